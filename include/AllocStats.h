@@ -0,0 +1,66 @@
+#pragma once
+
+namespace Connect4
+{
+    /**
+     * What a heap allocation was for, set by the innermost CONNECT4_ALLOC_SCOPE of the thread.
+     */
+    enum class AllocCategory { OTHER, BOARD, TREE, ROLLOUT };
+
+    /**
+     * Heap allocations (calls to operator new) and bytes asked for, by AllocCategory.
+     */
+    struct AllocCounts
+    {
+        static constexpr int NUM_CATEGORIES = 4;
+
+        long long allocations[NUM_CATEGORIES] = {};
+        long long bytes[NUM_CATEGORIES] = {};
+
+        long long totalAllocations() const;
+        long long totalBytes() const;
+        AllocCounts operator-(const AllocCounts& earlier) const;
+        AllocCounts& operator+=(const AllocCounts& other);
+        static const char* categoryName(int category); // "other", "board", "tree", "rollout"
+    };
+
+    /**
+     * Allocation accounting, compiled in with the CONNECT4_ALLOC_STATS CMake option.
+     *
+     * The option replaces the global operator new with one that counts, per thread, the calls and
+     * the bytes asked for under the category of the thread's innermost CONNECT4_ALLOC_SCOPE. Players
+     * put the counts of their play() in SearchStats::allocs, so a regression on a hot path shows up
+     * in the category of that path. Without the option nothing is counted, the counts stay 0 and
+     * the scopes compile to nothing.
+     */
+    class AllocStats
+    {
+    public:
+
+        static bool enabled();
+        static AllocCounts threadCounts(); // allocations of the calling thread so far
+    };
+
+#ifdef CONNECT4_ALLOC_STATS
+    /**
+     * Count the allocations of the thread under category until the end of the scope.
+     */
+    class AllocScope
+    {
+    public:
+
+        explicit AllocScope(AllocCategory category);
+        AllocScope(const AllocScope&) = delete;
+        AllocScope& operator=(const AllocScope&) = delete;
+        ~AllocScope();
+
+    private:
+
+        int previous_;
+    };
+
+#define CONNECT4_ALLOC_SCOPE(category) ::Connect4::AllocScope allocScope_(category)
+#else
+#define CONNECT4_ALLOC_SCOPE(category) ((void)0)
+#endif
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Player.h"
+
+namespace Connect4
+{
+    struct BatchResult
+    {
+        long long positions = 0;
+        long long errors = 0; // lines that are not a legal move sequence
+    };
+
+    /**
+     * Best move and score of many positions, on a pool of threads.
+     *
+     * Input is one position per line, the columns 1-7 played from the empty board (see
+     * Board::playMoves). Output is one line per position, in input order:
+     *
+     *   <moves> TAB <best column 1-7> TAB <score>    score as in SearchStats::score
+     *   <moves> TAB none                             the game is over
+     *   <moves> TAB error                            not a legal move sequence
+     *
+     * Lines are handed out in chunks of CHUNK_SIZE through a ring of slots: the calling thread reads
+     * chunks into free slots, workers analyze them in any order with their own player from the
+     * factory (seeded with seed + worker index), and a writer thread prints the finished chunks in
+     * order and frees their slots. At most window positions are in memory at a time, however long
+     * the input is.
+     */
+    class BatchAnalyzer
+    {
+    public:
+
+        using PlayerFactory = std::function<std::unique_ptr<Player>(int seed)>;
+
+        static constexpr int CHUNK_SIZE = 256;
+
+        explicit BatchAnalyzer(PlayerFactory factory);
+        void setNumThreads(int numThreads); // 0 (default): one thread per hardware thread
+        void setSeed(int seed);
+        void setWindow(int positions);      // most positions read but not yet written, default 65536
+        BatchResult run(std::istream& in, std::ostream& out);
+
+    private:
+
+        struct Chunk
+        {
+            std::vector<std::string> lines; // sized CHUNK_SIZE, the first numLines are used
+            int numLines = 0;
+            std::string output;
+            long long errors = 0;
+            bool done = false;
+        };
+
+        void worker_(int workerIndex);
+        void writer_(std::ostream& out, BatchResult& result);
+        static void analyze_(Player& player, const std::string& line, Chunk& chunk);
+
+        PlayerFactory factory_;
+        int numThreads_;
+        int seed_;
+        int window_;
+
+        std::vector<Chunk> ring_; // chunk n lives in slot n % ring_.size()
+        long long nextRead_;  // chunks handed to the workers
+        long long nextWork_;  // chunks taken by a worker
+        long long nextWrite_; // chunks written out
+        bool inputDone_;
+        std::mutex mutex_;
+        std::condition_variable slotFree_;
+        std::condition_variable workAvailable_;
+        std::condition_variable chunkDone_;
+    };
+}
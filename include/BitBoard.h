@@ -0,0 +1,436 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include "Board.h"
+#include "Globals.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Connect4
+{
+    /**
+     * Number of set bits in a mask.
+     */
+    inline int popCount(uint64_t x)
+    {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(x));
+#else
+        return __builtin_popcountll(x);
+#endif
+    }
+
+    /**
+     * Index of the lowest set bit. x must not be 0.
+     */
+    inline int lowestBitIndex(uint64_t x)
+    {
+        assert(x != 0);
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(x);
+#endif
+    }
+
+    /**
+     * 128 bit mask as two 64 bit words, for boards that don't fit in 64 bits (more than 63 cells
+     * with the sentinel row, such as 8x9). Plain struct rather than unsigned __int128, which MSVC
+     * doesn't have; the operators compile to the same few instructions.
+     */
+    struct Mask128
+    {
+        uint64_t lo;
+        uint64_t hi;
+
+        Mask128(uint64_t low = 0) : lo{ low }, hi{ 0 } {}
+        Mask128(uint64_t low, uint64_t high) : lo{ low }, hi{ high } {}
+
+        explicit operator bool() const { return (lo | hi) != 0; }
+        Mask128 operator~() const { return Mask128(~lo, ~hi); }
+        Mask128& operator|=(const Mask128& m) { lo |= m.lo; hi |= m.hi; return *this; }
+        Mask128& operator&=(const Mask128& m) { lo &= m.lo; hi &= m.hi; return *this; }
+        Mask128& operator^=(const Mask128& m) { lo ^= m.lo; hi ^= m.hi; return *this; }
+    };
+
+    inline Mask128 operator|(Mask128 a, const Mask128& b) { return a |= b; }
+    inline Mask128 operator&(Mask128 a, const Mask128& b) { return a &= b; }
+    inline Mask128 operator^(Mask128 a, const Mask128& b) { return a ^= b; }
+    inline bool operator==(const Mask128& a, const Mask128& b) { return a.lo == b.lo && a.hi == b.hi; }
+    inline bool operator!=(const Mask128& a, const Mask128& b) { return !(a == b); }
+
+    inline Mask128 operator+(const Mask128& a, const Mask128& b)
+    {
+        const uint64_t lo = a.lo + b.lo;
+        return Mask128(lo, a.hi + b.hi + (lo < a.lo));
+    }
+
+    inline Mask128 operator-(const Mask128& a, const Mask128& b)
+    {
+        return Mask128(a.lo - b.lo, a.hi - b.hi - (a.lo < b.lo));
+    }
+
+    inline Mask128 operator<<(const Mask128& m, int n)
+    {
+        if (n == 0)
+        {
+            return m;
+        }
+        if (n >= 64)
+        {
+            return Mask128(0, m.lo << (n - 64));
+        }
+        return Mask128(m.lo << n, (m.hi << n) | (m.lo >> (64 - n)));
+    }
+
+    inline Mask128 operator>>(const Mask128& m, int n)
+    {
+        if (n == 0)
+        {
+            return m;
+        }
+        if (n >= 64)
+        {
+            return Mask128(m.hi >> (n - 64), 0);
+        }
+        return Mask128((m.lo >> n) | (m.hi << (64 - n)), m.hi >> n);
+    }
+
+    inline int popCount(const Mask128& x)
+    {
+        return popCount(x.lo) + popCount(x.hi);
+    }
+
+    inline int lowestBitIndex(const Mask128& x)
+    {
+        return x.lo ? lowestBitIndex(x.lo) : 64 + lowestBitIndex(x.hi);
+    }
+
+    /**
+     * Hash of a position key, for the transposition tables.
+     */
+    struct MaskHash
+    {
+        size_t operator()(uint64_t key) const { return std::hash<uint64_t>()(key); }
+        size_t operator()(const Mask128& key) const { return std::hash<uint64_t>()(key.lo ^ (key.hi * 0x9E3779B97F4A7C15ull)); }
+    };
+
+    /**
+     * Compact bitboard representation of a Board, used by the search hot paths.
+     *
+     * Each column takes nRows + 1 bits; bit (col * (nRows + 1) + row) is the cell at (row, col).
+     * The extra bit on top of every column stays empty, so shifting a mask by one column never
+     * carries a piece over into the next column. A 6x7 board uses 49 bits of the 64 bit mask.
+     *
+     *  .  .  .  .  .  .  .   <- sentinel row
+     *  5 12 19 26 33 40 47
+     *  4 11 18 25 32 39 46
+     *  3 10 17 24 31 38 45
+     *  2  9 16 23 30 37 44
+     *  1  8 15 22 29 36 43
+     *  0  7 14 21 28 35 42   <- bottom row
+     *
+     * The mask type is a template parameter: BitBoard (64 bits, up to 7x8) is the one the engines
+     * use by default, WideBitBoard (128 bits, e.g. 8x9 or 10x11) covers the larger variants. Both
+     * are compiled in BitBoard.cpp.
+     */
+    template <typename MaskT>
+    class BasicBitBoard
+    {
+    public:
+
+        using Mask = MaskT;
+
+        BasicBitBoard() = default;
+        BasicBitBoard(size_t nRows, size_t nCols, int connect = CONNECT_SIZE);
+        explicit BasicBitBoard(const Board& board);
+
+        /**
+         * True if an nRows x nCols board (plus the sentinel row) fits in Mask.
+         */
+        static bool fits(size_t nRows, size_t nCols)
+        {
+            return (nRows + 1) * nCols <= 8 * sizeof(Mask);
+        }
+
+        int getNumRows() const { return nRows_; }
+        int getNumCols() const { return nCols_; }
+        int getConnect() const { return connect_; }
+        int getNumMoves() const { return numMoves_; }
+        Mask getAiMask() const { return ai_; }
+        Mask getHumanMask() const { return human_; }
+        Mask getMask() const { return ai_ | human_; }
+        Mask getBottomMask() const { return bottomMask_; }
+        Mask getBoardMask() const { return boardMask_; }
+
+        /**
+         * Unique key of the position: the AI pieces plus one bit on top of every column's pieces.
+         */
+        Mask key() const
+        {
+            return ai_ | (getMask() + bottomMask_);
+        }
+
+        /**
+         * One bit per playable column, set on the cell where the next piece in that column lands.
+         */
+        Mask possibleMoves() const
+        {
+            return (getMask() + bottomMask_) & boardMask_;
+        }
+
+        /**
+         * Drop a piece on the cell given by a single bit of possibleMoves().
+         */
+        void play(Mask moveBit, bool isAi)
+        {
+            assert((moveBit & possibleMoves()) == moveBit && popCount(moveBit) == 1);
+            if (isAi)
+            {
+                ai_ |= moveBit;
+            }
+            else
+            {
+                human_ |= moveBit;
+            }
+            numMoves_++;
+        }
+
+        /**
+         * Drop a piece on a column. The column must not be full.
+         */
+        void playColumn(int col, bool isAi)
+        {
+            play(possibleMoves() & columnMask(col), isAi);
+        }
+
+        bool canPlay(int col) const
+        {
+            return (possibleMoves() & columnMask(col)) != Mask(0);
+        }
+
+        bool isFull() const
+        {
+            return numMoves_ == nRows_ * nCols_;
+        }
+
+        /**
+         * Check if the pieces in mask contain connect in a row in any direction.
+         */
+        bool hasAlignment(Mask mask) const
+        {
+            const int h = nRows_ + 1;
+            //vertical, horizontal, diagonal '\' and diagonal '/'
+            const int shifts[] = { 1, h, h - 1, h + 1 };
+            if (connect_ == 4)
+            {
+                for (int shift : shifts)
+                {
+                    Mask m = mask & (mask >> shift);
+                    if (m & (m >> (2 * shift)))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            //bit i of m is set where a line of len pieces starts. Double len while it fits, then
+            //overlap two lines of len for the rest.
+            for (int shift : shifts)
+            {
+                Mask m = mask;
+                int len = 1;
+                for (; 2 * len <= connect_; len *= 2)
+                {
+                    m &= m >> (len * shift);
+                }
+                if (len < connect_)
+                {
+                    m &= m >> ((connect_ - len) * shift);
+                }
+                if (m)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Empty cells that would complete connect in a row for the pieces in mask
+         * (not necessarily playable yet, intersect with possibleMoves() for that).
+         */
+        Mask winningCells(Mask mask) const
+        {
+            const int h = nRows_ + 1;
+            const int shifts[] = { h, h - 1, h + 1 };
+            if (connect_ == 4)
+            {
+                //vertical: only three pieces below an empty cell.
+                Mask cells = (mask << 1) & (mask << 2) & (mask << 3);
+
+                //horizontal, diagonal '\' and diagonal '/': the empty cell can be anywhere in the line.
+                for (int shift : shifts)
+                {
+                    Mask pair = (mask << shift) & (mask << (2 * shift));
+                    cells |= pair & (mask << (3 * shift));
+                    cells |= pair & (mask >> shift);
+                    pair = (mask >> shift) & (mask >> (2 * shift));
+                    cells |= pair & (mask >> (3 * shift));
+                    cells |= pair & (mask << shift);
+                }
+                return cells & (boardMask_ ^ getMask());
+            }
+
+            //vertical: connect - 1 pieces below an empty cell.
+            Mask cells = mask << 1;
+            for (int k = 2; k < connect_; k++)
+            {
+                cells &= mask << k;
+            }
+
+            //other directions: the empty cell is at position p of the line, the pieces at k != p.
+            for (int shift : shifts)
+            {
+                for (int p = 0; p < connect_; p++)
+                {
+                    Mask line = ~Mask(0);
+                    for (int k = 0; k < connect_; k++)
+                    {
+                        if (k != p)
+                        {
+                            line &= k > p ? mask >> ((k - p) * shift) : mask << ((p - k) * shift);
+                        }
+                    }
+                    cells |= line;
+                }
+            }
+            return cells & (boardMask_ ^ getMask());
+        }
+
+        /**
+         * The minimax heuristic (MiniMaxAiPlayer::evaluate) of the position, from the AI player's
+         * point of view: every window of connect cells in a line scores 5 for connect - 1 AI pieces
+         * and an empty cell, 2 for connect - 2 AI pieces and two empty cells, -4 for connect - 1
+         * human pieces and an empty cell, and +-1000 for a complete line.
+         *
+         * All windows of a direction are counted at once: the pieces of each window are added up
+         * into bit planes, one bit per window start, so a count is a few ANDs and a popCount.
+         */
+        int windowScore() const
+        {
+            //as in Board::getWinner, four in a row is compiled with the window length fixed.
+            return connect_ == 4 ? windowScore_<4>() : windowScore_<0>();
+        }
+
+        Board::Markers getWinner() const
+        {
+            if (hasAlignment(ai_))
+            {
+                return Board::Markers::AI_PLAYER;
+            }
+            if (hasAlignment(human_))
+            {
+                return Board::Markers::HUMAN_PLAYER;
+            }
+            return Board::Markers::NONE;
+        }
+
+        bool gameEnded() const
+        {
+            return isFull() || getWinner() != Board::Markers::NONE;
+        }
+
+        Mask columnMask(int col) const
+        {
+            return ((Mask(1) << nRows_) - Mask(1)) << (col * (nRows_ + 1));
+        }
+
+        /**
+         * Column of the cell given by a single bit.
+         */
+        int columnOf(Mask moveBit) const
+        {
+            return lowestBitIndex(moveBit) / (nRows_ + 1);
+        }
+
+    private:
+
+        /**
+         * windowScore() over windows of Connect cells, or connect_ cells if Connect is 0.
+         */
+        template <int Connect>
+        int windowScore_() const
+        {
+            const int connect = Connect > 0 ? Connect : connect_;
+            const int h = nRows_ + 1;
+            const int shifts[] = { 1, h, h - 1, h + 1 };
+            int numPlanes = 1;
+            while ((1 << numPlanes) <= connect)
+            {
+                numPlanes++;
+            }
+            assert(numPlanes <= 6);
+            int score = 0;
+            for (int shift : shifts)
+            {
+                //windows lying entirely on the board, and the AI and human counts of each window.
+                Mask valid = boardMask_;
+                Mask aiPlanes[6] = { 0, 0, 0, 0, 0, 0 };
+                Mask humanPlanes[6] = { 0, 0, 0, 0, 0, 0 };
+                Mask anyAi = 0;
+                Mask anyHuman = 0;
+                for (int k = 0; k < connect; k++)
+                {
+                    valid &= boardMask_ >> (k * shift);
+                    Mask ai = ai_ >> (k * shift);
+                    Mask human = human_ >> (k * shift);
+                    anyAi |= ai;
+                    anyHuman |= human;
+                    for (int p = 0; p < numPlanes; p++)
+                    {
+                        Mask aiCarry = aiPlanes[p] & ai;
+                        aiPlanes[p] ^= ai;
+                        ai = aiCarry;
+                        Mask humanCarry = humanPlanes[p] & human;
+                        humanPlanes[p] ^= human;
+                        human = humanCarry;
+                    }
+                }
+                auto countIs = [&valid, numPlanes](const Mask* planes, int count)
+                {
+                    Mask m = valid;
+                    for (int p = 0; p < numPlanes; p++)
+                    {
+                        m &= ((count >> p) & 1) ? planes[p] : ~planes[p];
+                    }
+                    return m;
+                };
+                const Mask noAi = ~anyAi;
+                const Mask noHuman = ~anyHuman;
+                score += 1000 * (popCount(countIs(aiPlanes, connect)) - popCount(countIs(humanPlanes, connect)));
+                score += 5 * popCount(countIs(aiPlanes, connect - 1) & noHuman);
+                score += 2 * popCount(countIs(aiPlanes, connect - 2) & noHuman);
+                score -= 4 * popCount(countIs(humanPlanes, connect - 1) & noAi);
+            }
+            return score;
+        }
+
+        Mask ai_ = 0;
+        Mask human_ = 0;
+        Mask bottomMask_ = 0;
+        Mask boardMask_ = 0;
+        int nRows_ = 0;
+        int nCols_ = 0;
+        int connect_ = CONNECT_SIZE;
+        int numMoves_ = 0;
+    };
+
+    using BitBoard = BasicBitBoard<uint64_t>;
+    using WideBitBoard = BasicBitBoard<Mask128>;
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstddef>
+#include <string>
 #include <vector>
+#include "Globals.h"
 
 namespace Connect4
 {
@@ -13,10 +16,11 @@ namespace Connect4
             NONE,
         };
 
-        Board(size_t nRows = 6, size_t nCols = 7);
+        Board(size_t nRows = 6, size_t nCols = 7, int connect = CONNECT_SIZE);
         Board(std::vector<std::vector <Markers>>& board); //for testing an arbitrary starting state.
         size_t getNumCols() const;
         size_t getNumRows() const; //make them inline
+        int getConnect() const;
         Board::Markers getWinner() const;
         bool dropPiece(int col, Markers marker);
         bool validMovesExist() const;
@@ -24,14 +28,19 @@ namespace Connect4
         void print() const;
         void reset();
         void flipMarkers();
+        bool playMoves(const std::string& moves);
         const std::vector<std::vector <Markers>>& getBoard() const;
         const std::vector<int>& getMoves() const;
         virtual ~Board() {};
 
     private:
 
+        template <int Connect>
+        Markers winner_() const;
+
         size_t nCols_;
         size_t nRows_;
+        int connect_; // pieces in a row needed to win
         std::vector<std::vector <Markers>> board_;
         std::vector<int> validLocations_;
 
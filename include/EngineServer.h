@@ -0,0 +1,86 @@
+#pragma once
+#include <condition_variable>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Board.h"
+#include "MctsAiPlayer.h"
+#include "SearchStats.h"
+
+namespace Connect4
+{
+    class MiniMaxAiPlayer;
+
+    /**
+     * Line based engine protocol in the spirit of UCI, for driving the engines from another process.
+     * One command per line:
+     *
+     *   isready                                     -> readyok
+     *   newgame                                     forget the search trees of the previous game
+     *   position startpos [moves 4453]              columns 1-7 played from the empty board
+     *   engine mcts|minimax
+     *   go [iterations I] [depth D] [movetime MS]   -> info lines while searching, then bestmove C
+     *   stop                                        end the search early, it still answers bestmove
+     *   quit
+     *
+     * The engine plays the side to move. iterations applies to MCTS and depth to minimax; movetime
+     * limits both, and for MCTS replaces the iteration count. bestmove is a column 1-7, or "none"
+     * when the game is over.
+     *
+     *   info depth D score S nodes N nps R time MS
+     *
+     * The score is for the side to move: the MCTS mean reward in [-1, 1] or the minimax evaluation.
+     * Searches run on a worker thread, so stop and isready are answered while searching; any other
+     * command waits for the search to end first. The players live as long as the server, so MCTS
+     * keeps the subtree of the position it is given next, as it does in a game. A bad command
+     * answers "error <reason>".
+     */
+    class EngineServer
+    {
+    public:
+
+        enum class Engine { MCTS, MINIMAX };
+
+        EngineServer();
+        void setDefaultIterations(int iterations);
+        void setDefaultDepth(int depth);
+        void setInfoInterval(int milliseconds);
+
+        /**
+         * Serve commands from in until quit or end of input. Returns 0.
+         */
+        int run(std::istream& in, std::ostream& out);
+        ~EngineServer();
+
+    private:
+
+        bool handle_(const std::string& line);
+        void position_(std::istringstream& args);
+        void go_(std::istringstream& args);
+        void search_(Player* player, int moveTimeMs);
+        void waitForSearch_();
+        void newGame_();
+        void send_(const std::string& line);
+        void sendInfo_(const SearchStats& stats);
+
+        std::ostream* out_;
+        std::mutex outMutex_;
+
+        Board board_;
+        Engine engine_;
+        int defaultIterations_;
+        int defaultDepth_;
+        int infoIntervalMs_;
+        std::unique_ptr<MctsAiPlayer> mcts_;
+        std::unique_ptr<MiniMaxAiPlayer> miniMax_; // rebuilt when the depth changes
+        int miniMaxDepth_;
+
+        std::thread searchThread_;
+        Player* searching_; // player of the running search, nullptr when idle
+        std::mutex searchMutex_;
+        std::condition_variable searchDone_;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+namespace Connect4
+{
+    /**
+     * Small-state pseudo random generator (xorshift64*) for rollouts.
+     * https://en.wikipedia.org/wiki/Xorshift#xorshift*
+     *
+     * Eight bytes of state and a handful of instructions per number, compared to 2.5KB of state for
+     * std::mt19937. The statistical quality is more than enough for random playouts.
+     */
+    class FastRandom
+    {
+    public:
+
+        explicit FastRandom(uint64_t seed = 0)
+        {
+            this->seed(seed);
+        }
+
+        /**
+         * Seed through splitmix64, so that consecutive seeds give unrelated sequences and the
+         * state is never 0 (xorshift gets stuck at 0).
+         */
+        void seed(uint64_t seed)
+        {
+            uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            state_ = (z ^ (z >> 31)) | 1;
+        }
+
+        uint64_t next()
+        {
+            state_ ^= state_ >> 12;
+            state_ ^= state_ << 25;
+            state_ ^= state_ >> 27;
+            return state_ * 0x2545F4914F6CDD1Dull;
+        }
+
+        /**
+         * Random number in [0, bound). Uses the multiply-shift reduction instead of a modulo.
+         * The bias is negligible for the small bounds used here.
+         */
+        uint32_t bounded(uint32_t bound)
+        {
+            return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+        }
+
+    private:
+
+        uint64_t state_;
+    };
+}
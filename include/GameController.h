@@ -14,7 +14,7 @@ namespace Connect4
         std::shared_ptr<GameView> gameView_;
 
     public:
-        GameController(bool isSimulation = false);
+        GameController();
         void run();
         virtual ~GameController() {};
     };
@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Connect4
+{
+    /**
+     * Binary game record file (append-only, little-endian):
+     *
+     *   file header: "C4GR", uint16 version (2), uint16 reserved    (8 bytes)
+     *   records, each starting on a 4 byte boundary:
+     *     GameRecordHeader                                          (20 bytes)
+     *     numMoves columns, one byte each (0 based), padded to a multiple of 4
+     *     numMoves move times in microseconds, uint32 each
+     *
+     * Every record has the board it was played on, so one file can hold several variants. A 6x7
+     * game takes at most 20 + 44 + 168 bytes. Every field is naturally aligned in a mapped file, so
+     * the reader hands out pointers into the mapping instead of parsing.
+     */
+    struct GameRecordHeader
+    {
+        uint16_t numMoves;
+        int8_t result;          // 1: the AI engine won, -1: the shadow engine won, 0: tie
+        uint8_t flags;          // SHADOW_FIRST
+        uint16_t aiEngineId;
+        uint16_t shadowEngineId;
+        uint32_t aiSeed;
+        uint32_t shadowSeed;
+        uint8_t numRows;
+        uint8_t numCols;
+        uint8_t connect;        // pieces in a row to win
+        uint8_t reserved;
+
+        static constexpr uint8_t SHADOW_FIRST = 1; // the shadow engine made the first move
+    };
+    static_assert(sizeof(GameRecordHeader) == 20, "GameRecordHeader is part of the file format");
+
+    /**
+     * One game, as built while playing it.
+     */
+    struct GameRecord
+    {
+        GameRecordHeader header = {};
+        std::vector<uint8_t> moves;
+        std::vector<uint32_t> moveTimesUs;
+    };
+
+    /**
+     * One game inside a mapped file. Only valid while the reader is alive.
+     */
+    struct GameRecordView
+    {
+        const GameRecordHeader* header;
+        const uint8_t* moves;
+        const uint32_t* moveTimesUs;
+    };
+
+    /**
+     * Buffered, thread safe writer. Records are appended to the file (a new file gets the file
+     * header) and written out when the buffer is full, on flush() and on destruction. A record cut
+     * short at the end of an existing file (an interrupted writer) is cut off before appending, so
+     * the new records stay aligned; a file of another format or version is not opened.
+     */
+    class GameRecordWriter
+    {
+    public:
+
+        GameRecordWriter(const std::string& path, size_t bufferSize = 1 << 20);
+        bool isOpen() const;
+        void write(const GameRecord& record);
+        void flush();
+        virtual ~GameRecordWriter();
+
+    private:
+
+        void flushLocked_();
+        bool openForAppend_(const std::string& path);
+
+        std::FILE* file_;
+        std::vector<char> buffer_;
+        size_t bufferSize_;
+        std::mutex mutex_;
+    };
+
+    /**
+     * Memory mapped reader. Iterating yields a GameRecordView per game; a record cut short at the end
+     * of the file (an interrupted writer), or one with more moves than its board has cells, ends the
+     * iteration.
+     */
+    class GameRecordReader
+    {
+    public:
+
+        class Iterator
+        {
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = GameRecordView;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const GameRecordView*;
+            using reference = const GameRecordView&;
+
+            Iterator(const char* data, size_t size, size_t offset);
+            const GameRecordView& operator*() const { return view_; }
+            const GameRecordView* operator->() const { return &view_; }
+            Iterator& operator++();
+            bool operator==(const Iterator& other) const { return offset_ == other.offset_; }
+            bool operator!=(const Iterator& other) const { return offset_ != other.offset_; }
+
+        private:
+
+            void load_();
+
+            const char* data_;
+            size_t size_;
+            size_t offset_;
+            size_t recordSize_;
+            GameRecordView view_;
+        };
+
+        explicit GameRecordReader(const std::string& path);
+        GameRecordReader(const GameRecordReader&) = delete;
+        GameRecordReader& operator=(const GameRecordReader&) = delete;
+        bool isOpen() const;
+        Iterator begin() const;
+        Iterator end() const;
+        virtual ~GameRecordReader();
+
+    private:
+
+        void unmap_();
+
+        const char* data_;
+        size_t size_;
+#ifdef _WIN32
+        void* fileHandle_;
+        void* mappingHandle_;
+#endif
+    };
+
+    /**
+     * Bytes taken by a record with numMoves moves.
+     */
+    inline size_t gameRecordSize(size_t numMoves)
+    {
+        return sizeof(GameRecordHeader) + ((numMoves + 3) & ~size_t{ 3 }) + numMoves * sizeof(uint32_t);
+    }
+}
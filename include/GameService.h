@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "OpeningBook.h"
+#include "Player.h"
+#include "PositionCache.h"
+
+namespace Connect4
+{
+    /**
+     * Answer to GameService::requestMove().
+     */
+    struct MoveResult
+    {
+        enum class Source { SEARCH, BOOK, CACHE };
+
+        int column = -1;     // 0 based
+        double score = 0.0;  // for the side to move, as in SearchStats::score
+        Source source = Source::SEARCH;
+        bool applied = true; // false if the session was closed before the move was found
+        double queueMs = 0.0; // from requestMove() until a worker took the request
+        double totalMs = 0.0; // from requestMove() until the move was found
+    };
+
+    struct ServiceStats
+    {
+        long long sessions = 0; // open now
+        long long moves = 0;
+        long long bookMoves = 0;
+        long long cacheMoves = 0;
+        long long searches = 0;
+        long long queued = 0;   // requests waiting for a worker now
+    };
+
+    /**
+     * Engine moves for many concurrent 6x7 games, in process.
+     *
+     * A session is one game: the columns played so far and the engine that answers for it. The
+     * caller plays the opponent's moves with playMove() and asks for the engine's with
+     * requestMove(), at most one request per session at a time. Requests wait in one queue, first
+     * come first served, for a fixed pool of worker threads. Each worker owns one player per engine
+     * and uses it for whichever session it serves, so a session costs a few bytes rather than a
+     * search tree, and thousands of them can be open at once.
+     *
+     * A request is answered, in order of preference, from the opening book, from the position cache,
+     * or by a search within its time budget. The book is immutable and the cache lockless, so the
+     * workers share both without waiting for each other. A search result goes into the cache with
+     * its budget, and answers later requests for the same position and engine with at most that
+     * budget.
+     *
+     * The callback runs on the worker thread, after the move has been played in the session; it may
+     * call back into the service. Requests still queued when the service is destroyed are dropped
+     * without a callback, and running searches are stopped.
+     */
+    class GameService
+    {
+    public:
+
+        using SessionId = uint64_t;
+        enum class Engine { MCTS, MINIMAX };
+        using MoveCallback = std::function<void(SessionId, const MoveResult&)>;
+
+        explicit GameService(int numThreads = 0, size_t cacheEntries = 1 << 20); // 0 threads: one per hardware thread
+
+        //settings of the workers, to be made before the first request.
+        void setMiniMaxDepth(int depth); // most depth of a search within the budget, default 8
+        void setOpeningBook(std::shared_ptr<const OpeningBook> book);
+
+        SessionId createSession(Engine engine);
+        bool closeSession(SessionId session);
+
+        /**
+         * Play column (0 based) for the side to move. False if the session is unknown or waiting for
+         * the engine, the game is over, or the column is full.
+         */
+        bool playMove(SessionId session, int column);
+
+        /**
+         * Queue a request for the engine to play the side to move, searching for at most budgetMs
+         * (> 0). False if the session is unknown or already waiting, or the game is over.
+         */
+        bool requestMove(SessionId session, int budgetMs, MoveCallback done);
+
+        std::string getMoves(SessionId session) const; // columns 1-7 played so far, empty if unknown
+        ServiceStats getStats() const;
+        int getNumThreads() const;
+        ~GameService();
+
+    private:
+
+        struct Session
+        {
+            std::string moves;
+            Engine engine;
+            bool ended;
+            bool waiting; // a request is queued or being served
+        };
+
+        struct Request
+        {
+            SessionId session;
+            std::string moves;
+            Engine engine;
+            int budgetMs;
+            MoveCallback done;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        void worker_(int workerIndex);
+        bool search_(int workerIndex, Player& player, Board& board);
+
+        int numThreads_;
+        int miniMaxDepth_;
+        std::shared_ptr<const OpeningBook> book_;
+        PositionCache cache_;
+
+        mutable std::mutex mutex_; // guards the sessions, the queue, searching_ and stopping_
+        std::unordered_map<SessionId, Session> sessions_;
+        SessionId nextSession_;
+        std::deque<Request> queue_;
+        std::condition_variable workAvailable_;
+        std::vector<Player*> searching_; // player searching on each worker, nullptr when idle
+        bool stopping_;
+
+        std::atomic<long long> moves_;
+        std::atomic<long long> bookMoves_;
+        std::atomic<long long> cacheMoves_;
+        std::vector<std::thread> workers_;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <vector>
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 
@@ -23,12 +24,28 @@ namespace Connect4
 
         int dropPieceX_;
 
+        //geometry built once in the constructor, only the cell colors change afterwards.
+        sf::RectangleShape background_;
+        sf::VertexArray cells_;
+        sf::VertexArray gridLines_;
+        sf::CircleShape pieceToDrop_;
+
+        std::vector<int> shownMoves_; // column heights of the board last drawn
+        bool dirty_;
+
+        void buildGeometry_();
+        void updateCells_();
 
     public:
+
+        static constexpr unsigned int FRAME_RATE_LIMIT = 60;
+        static constexpr int CIRCLE_SEGMENTS = 32;
+
         GameView() = delete;
         GameView(std::shared_ptr<Board> board);
         sf::RenderWindow* windowHandle() const;
         void setPiecePosition(int mouseX);
+        void invalidate();
         void draw();
         int gridSize() const;
         virtual ~GameView() {};
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "FastRandom.h"
+#include "GameService.h"
+
+namespace Connect4
+{
+    struct LoadReport
+    {
+        long long moves = 0; // engine moves answered
+        long long games = 0; // games played to the end
+        double seconds = 0.0;
+        double movesPerSecond = 0.0;
+        double p50Ms = 0.0;  // move latency, from GameService::requestMove() to the answer
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+        double meanQueueMs = 0.0;
+        ServiceStats service; // when the last answer came in
+    };
+
+    /**
+     * Load on a GameService from simulated clients, to measure move latency under load.
+     *
+     * Every client keeps one game going against the engine, playing random legal moves itself. After
+     * each engine move it thinks for a random time (up to twice the think time) before it answers,
+     * and it starts a new game, with the other side first, when one ends. Clients are stepped on the
+     * calling thread and answers arrive on the service's workers. No new moves are asked for after
+     * the duration; run() returns once the requests in flight are answered.
+     */
+    class LoadGenerator
+    {
+    public:
+
+        explicit LoadGenerator(GameService& service);
+        void setClients(int numClients);              // concurrent games, default 1000
+        void setEngine(GameService::Engine engine);   // default MCTS
+        void setBudget(int milliseconds);             // per engine move, default 10
+        void setThinkTime(int milliseconds);          // mean, default 100. 0: ask again at once
+        void setDuration(int milliseconds);           // default 10000
+        void setSeed(int seed);
+        LoadReport run();
+
+    private:
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Client
+        {
+            GameService::SessionId session;
+            FastRandom random;
+            bool engineFirst;
+        };
+
+        void step_(int clientIndex);
+        void answered_(int clientIndex, const MoveResult& result);
+        Clock::time_point thinkUntil_(Client& client) const;
+
+        GameService& service_;
+        int numClients_;
+        GameService::Engine engine_;
+        int budgetMs_;
+        int thinkMs_;
+        int durationMs_;
+        int seed_;
+
+        std::vector<Client> clients_;
+        long long games_; // only touched by the calling thread
+
+        std::mutex mutex_; // guards everything below
+        std::condition_variable wake_;
+        std::priority_queue<std::pair<Clock::time_point, int>, std::vector<std::pair<Clock::time_point, int>>, std::greater<std::pair<Clock::time_point, int>>> due_; // (time, client) to step
+        long long inFlight_;
+        std::vector<double> latencies_;
+        double queueMs_;
+    };
+}
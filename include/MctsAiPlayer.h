@@ -2,67 +2,178 @@
 
 #include "Player.h"
 #include "Board.h" 
+#include "BitBoard.h"
+#include "RolloutEngine.h"
 #include <vector>
-#include <random>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <memory>
 
 namespace Connect4
 {
-    class Node
+    /**
+     * Search tree node. BoardT is BitBoard or WideBitBoard, see BasicMctsAiPlayer.
+     */
+    template <typename BoardT>
+    class MctsNode
     {
+    public:
+
+        using Node = MctsNode;
+        using Mask = typename BoardT::Mask;
+
+        // Game-theoretic value of a node, from the point of view of the player who moved into it.
+        enum class Proof : char
+        {
+            UNKNOWN,
+            WIN,
+            LOSS,
+            DRAW,
+        };
+
     private:
 
         std::vector<Node*> children_;
-        std::vector<int> triedMoves_;
-        Board board_;
+        std::vector<int> edgeVisits_; // visits through each child edge, they differ from the child's visits in a DAG
+        BoardT board_;
+        Mask untriedMoves_; // one bit per move that has no child yet
         int visits_;
-        int reward_;
-        Node* parent_;
-        void setParent_(Node* parent);
+        double reward_;         // summed playout results, or heuristic values in [-1, 1] (see LeafEvaluation)
+        int amafVisits_;        // all-moves-as-first: playouts in which this node's move was played later
+        double amafReward_;
+        double meanReward_;     // reward_ / visits_
+        double invSqrtVisits_;  // 1 / sqrt(visits_)
+        bool isTerminal_;
+        Proof proof_;
+        unsigned int mark_;     // garbage collection epoch in which the node was last reached
 
     public:
 
-        Node(Board& board);
+        MctsNode(const BoardT& board);
+        void reset(const BoardT& board);
         bool isTerminal() const;
-        const Board& getBoard() const; //state.
+        const BoardT& getBoard() const; //state.
         const std::vector<Node*>& getChildren() const;
-        const std::vector<int>& getTriedMoves() const;
-        void addMove(int move);
+        Mask getMoveTo(const Node* child) const;
+        Mask getUntriedMoves() const;
+        Mask popUntriedMove();
         void addChild(Node* child);
+        void removeChild(size_t childIndex);
         int getVisits() const;
+        int getEdgeVisits(size_t childIndex) const;
+        void updateEdge(const Node* child, int count);
         bool isFullyExpanded() const;
-        int getReward() const;
-        void updateVisits();
-        void updateReward(int reward);
-        Node* getParent() const;
+        double getReward() const;
+        double getMeanReward() const;
+        double getInvSqrtVisits() const;
+        int getAmafVisits() const;
+        double getAmafMeanReward() const;
+        void updateAmaf(double reward);
+        void update(double reward, int count = 1);
+        Proof getProof() const;
+        void setProof(Proof proof);
+        unsigned int getMark() const;
+        void setMark(unsigned int mark);
 
     };
 
-    class MctsAiPlayer :public Player
+    /**
+     * Monte Carlo tree search player. The board representation is a template parameter so that
+     * variants larger than 64 bits can be searched with 128 bit masks: use MctsAiPlayer for boards
+     * that fit in a BitBoard and WideMctsAiPlayer for the others, or makeMctsPlayer() to pick.
+     * Both are compiled in MctsAiPlayer.cpp.
+     */
+    template <typename BoardT>
+    class BasicMctsAiPlayer :public Player
     {
     public:
 
-        MctsAiPlayer() = delete;
-        MctsAiPlayer(int iterations, int randSeed);
+        using Node = MctsNode<BoardT>;
+        using Mask = typename BoardT::Mask;
+
+        BasicMctsAiPlayer() = delete;
+        BasicMctsAiPlayer(int iterations, int randSeed);
         virtual void play(Board& board) override;
-        virtual ~MctsAiPlayer();
+        virtual void startPondering(const Board& board) override;
+        virtual void stopPondering() override;
+        virtual void stop() override;
+        virtual void clearStop() override;
+        void setIterations(int iterations);
+        void setRolloutsPerLeaf(int rolloutsPerLeaf);
+        void setTimeBudget(int milliseconds, int maxNodes = 0);
+        void setSolver(bool useSolver);
+        void setTranspositions(bool useTranspositions);
+        void setRolloutPolicy(RolloutPolicy policy);
+        void setSimdLanes(int lanes);
+        void setRave(bool useRave, int equivalence = 300);
+        void setLeafEvaluation(LeafEvaluation leafEvaluation, int plies);
+        void setNodeBudget(size_t maxNodes);
+        virtual ~BasicMctsAiPlayer();
 
     private:
 
         int iterations_;
-        std::vector<Node*> nodes_;
+        int rolloutsPerLeaf_;
+        int timeBudgetMs_;
+        int maxNodes_;
+        bool useSolver_;
+        bool useTranspositions_;
+        bool useRave_;
+        int raveEquivalence_;
+        LeafEvaluation leafEvaluation_;
+        int leafPlies_; // playout cutoff or alpha-beta depth, see setLeafEvaluation
+        size_t nodeBudget_;
+        void search_(Node* root, bool isAiTurn);
+        void searchTimed_(Node* root);
+        Node* findRoot_(const BoardT& board);
+        void ponder_();
+        void reportProgress_(const Node* root);
+        bool canStopEarly_(const Node* root, double remainingVisits) const;
+        Node* mostVisitedChild_(const Node* v) const;
+        Node* provenWinChild_(const Node* v) const;
+        bool updateProof_(Node* v);
+        Node* newNode_(const BoardT& board);
+        void collectGarbage_(Node* root);
+        void prune_(Node* root);
+        size_t liveNodes_() const;
+
+        std::vector<Node*> nodes_;     // every node allocated, live or free. Nodes are only deleted with the player.
+        std::vector<Node*> freeNodes_; // nodes ready to be reused
+        std::vector<Node*> stack_;     // scratch space for tree walks
+        std::vector<int> visitScratch_;
+        unsigned int markEpoch_;
+        size_t nodesCreated_;
+        SearchStats* searchStats_; // &stats_ while play() searches, nullptr while pondering
+        std::chrono::steady_clock::time_point searchStart_; // of the current or last play()
+        size_t searchFirstNode_;   // nodesCreated_ when play() started
+        std::vector<Node*> path_; // nodes visited by the current iteration, root first
+        std::unordered_map<Mask, Node*, MaskHash> table_; // position key -> node, when transpositions are merged
+        Node* root_; // root of the search tree kept between moves, nullptr before the first move
+
+        std::thread ponderThread_;
+        std::atomic<bool> stopPondering_;
+        std::atomic<bool> stopSearch_; // set by stop() until clearStop(), ends play() early
         Node* treePolicy_(Node* v, bool& isAiTurn);
         Node* expand_(Node* v, bool& isAiTurn);
         Node* bestChild(const Node* v, float exploreFactor);
-        int defaultPolicy(const Node* v, bool isAiTurn);
-        void backup_(Node* v, int reward, bool isAiTurn);
-
-        // Mersenne Twister Random number engine
-        // https://cplusplus.com/reference/random/mersenne_twister_engine/
-        // Suitable for Monte Carlo Experiments, generates a large series with approximately uniform distribution.
-        // Initialize with a hardware based random device engine 
-        // static std::random_device randDev
-        std::mt19937 mtRand_;
+        double defaultPolicy(const Node* v, bool isAiTurn);
+        void backup_(double reward, int numRollouts, bool isAiTurn);
+        void backupAmaf_(const BoardT& finalBoard, double reward, bool isAiTurn);
+
+        // Allocation-free bitboard playouts with a small-state PRNG (xorshift64*).
+        // Replaces std::mt19937 + uniform_int_distribution + Board copies, which dominated the search time.
+        RolloutEngine rolloutEngine_;
     };
-}
 
+    using MctsAiPlayer = BasicMctsAiPlayer<BitBoard>;
+    using WideMctsAiPlayer = BasicMctsAiPlayer<WideBitBoard>;
+    extern template class BasicMctsAiPlayer<BitBoard>;
+    extern template class BasicMctsAiPlayer<WideBitBoard>;
 
+    /**
+     * MCTS player for nRows x nCols boards: a MctsAiPlayer if the board fits in 64 bits, else a
+     * WideMctsAiPlayer.
+     */
+    std::unique_ptr<Player> makeMctsPlayer(size_t nRows, size_t nCols, int iterations, int randSeed);
+}
@@ -2,6 +2,9 @@
 
 #include "Player.h"
 #include "Board.h" 
+#include <unordered_map>
+#include <thread>
+#include <atomic>
 
 namespace Connect4
 {
@@ -13,15 +16,45 @@ namespace Connect4
         MiniMaxAiPlayer(int depth);
         virtual void play(Board& board) override;
         virtual void playNoAlphaBeta(Board& board);
-        virtual ~MiniMaxAiPlayer() {};
+        virtual void startPondering(const Board& board) override;
+        virtual void stopPondering() override;
+        virtual void stop() override;
+        virtual void clearStop() override;
+        void setTimeBudget(int milliseconds);
+        int evaluate(const Board& board) const;
+        virtual ~MiniMaxAiPlayer();
 
     private:
         int computeScore_(const Board& board) const;
-        int lineScore_(Board::Markers m1, Board::Markers m2, Board::Markers m3, Board::Markers m4) const;
+        template <int Connect>
+        int windowsScore_(const Board& board) const;
+        int lineScore_(int numAiMarkers, int numHumanMarkers, int connect) const;
+        bool iterativeDeepening_(const Board& board, int& bestMove, int& bestScore);
         int miniMax_(const Board& currentBoard, int& bestMove, int depth, int alpha, int beta, bool isMaximizingPlayer);
         int miniMaxBasic(const Board& currentBoard, int& bestMove, int depth, bool isMaximizingPlayer);
+        void ponder_(Board board);
+        void reportProgress_(int bestMove, int bestValue);
+        bool stopped_() const;
         const int depth_;
         const int WINNING_SCORE;
+        int rootDepth_; // depth of the current iterative deepening iteration
+        int rootFirst_; // root move searched first: the best move of the previous iteration, or -1
+
+        struct PonderedMove
+        {
+            int move;
+            int score;
+            int depth;
+        };
+        std::unordered_map<uint64_t, PonderedMove> ponderMoves_; // position key (BitBoard::key) -> result found while pondering
+        std::thread ponderThread_;
+        std::atomic<bool> stopSearch_;    // interrupts play(), set by stop() until clearStop()
+        std::atomic<bool> stopPondering_; // interrupts ponder_(), set by stopPondering()
+        SearchStats* searchStats_; // &stats_ while play() searches, nullptr while pondering
+        std::chrono::steady_clock::time_point searchStart_;
+        int timeBudgetMs_; // 0: search to depth_
+        std::chrono::steady_clock::time_point deadline_;
+        bool timeUp_; // play() reached deadline_
 
     };
 }
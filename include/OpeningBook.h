@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include "Board.h"
+
+namespace Connect4
+{
+    /**
+     * Best moves of known 6x7 positions, to answer without searching.
+     *
+     * The book reads the output of Connect4Cli batch: "moves TAB column TAB score" per line, with
+     * columns 1-7 and the score for the side to move (see BatchAnalyzer). Lines without a move are
+     * skipped. Every position is also entered mirrored, so a book made for one side of the board
+     * covers the other. Positions are keyed by BitBoard::key().
+     *
+     * A loaded book is only read, so any number of threads can share one (through a
+     * std::shared_ptr<const OpeningBook>) without locking.
+     */
+    class OpeningBook
+    {
+    public:
+
+        /**
+         * Add the positions of in. Returns the number of lines added; lines that are not a legal
+         * position and move are skipped.
+         */
+        long long load(std::istream& in);
+        bool lookup(const Board& board, int& column, double& score) const;
+        size_t size() const;
+
+    private:
+
+        struct Entry
+        {
+            int column; // 0 based
+            double score;
+        };
+
+        bool add_(const std::string& moves, int column, double score);
+
+        std::unordered_map<uint64_t, Entry> entries_;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "Board.h"
+#include "BitBoard.h"
+
+namespace Connect4
+{
+    /**
+     * Perft: the number of move sequences of exactly depth moves from a position. A position where
+     * the game is over (won or full) has no moves, so sequences stop there and aren't counted.
+     * The counts from the empty board (ParallelPerft::KNOWN_COUNTS) check any board representation, and the
+     * speed (nodes/s) tracks the move generation.
+     *
+     * perft() walks the Board with getMoves() and dropPiece(), one thread.
+     */
+    long long perft(const Board& board, int depth, Board::Markers toMove = Board::Markers::AI_PLAYER);
+
+    /**
+     * Perft on bitboards, on a pool of threads sharing a hash table of subtree counts.
+     *
+     * The positions a few moves deep are split between the threads. Transpositions are looked up in
+     * the table (position key and remaining depth -> count) before being searched. The table is
+     * lockless: each entry stores key ^ data next to data, so an entry torn by concurrent writes fails
+     * the key check and is treated as a miss.
+     */
+    class ParallelPerft
+    {
+    public:
+
+        //perft of the empty 6x7 board for depths 0, 1, ...
+        static const long long KNOWN_COUNTS[];
+        static const int NUM_KNOWN_COUNTS;
+
+        explicit ParallelPerft(int numThreads = 0, size_t hashEntries = 1 << 22);
+        long long count(const BitBoard& board, int depth, bool isAiTurn);
+
+    private:
+
+        struct Entry
+        {
+            std::atomic<uint64_t> check; // key ^ data
+            std::atomic<uint64_t> data;  // count << 6 | depth
+        };
+
+        long long search_(const BitBoard& board, int depth, bool isAiTurn);
+        bool probe_(uint64_t key, int depth, long long& count) const;
+        void store_(uint64_t key, int depth, long long count);
+
+        int numThreads_;
+        size_t hashMask_;
+        std::unique_ptr<Entry[]> table_;
+    };
+}
@@ -1,4 +1,8 @@
 #pragma once
+#include <chrono>
+#include <functional>
+#include "AllocStats.h"
+#include "SearchStats.h"
 
 namespace Connect4
 {
@@ -9,6 +13,86 @@ namespace Connect4
 
         Player() = default;
         virtual void play(Board& board) = 0;
+
+        // Pondering: search in the background while the opponent (HUMAN_PLAYER) is to move on board.
+        // The next play() stops it and reuses what was found. Players that don't ponder ignore this.
+        virtual void startPondering(const Board& /*board*/) {}
+        virtual void stopPondering() {}
+
+        // Ask a play() running on another thread to return as soon as possible; it still makes a
+        // (weaker) move. A stop() that comes before play() starts is kept, play() then returns at
+        // once. The request stays until clearStop(): whoever starts a search it may stop calls
+        // clearStop() first, under the lock that publishes the search to the stopping thread.
+        // Players that can't be interrupted ignore both.
+        virtual void stop() {}
+        virtual void clearStop() {}
+
+        // Statistics of the search for the last move played. With a stream set, every move also
+        // writes them to it as a JSON line.
+        const SearchStats& getSearchStats() const { return stats_; }
+        void setStatsStream(std::ostream* out) { statsStream_ = out; }
+
+        // Called on the searching thread about every intervalMs while play() runs, with the stats
+        // so far (move and score are the current best). Players that can't report ignore this.
+        using ProgressCallback = std::function<void(const SearchStats&)>;
+        void setProgressCallback(ProgressCallback callback, int intervalMs = 500)
+        {
+            progress_ = callback;
+            progressInterval_ = std::chrono::milliseconds(intervalMs);
+        }
         virtual ~Player() {};
+
+    protected:
+
+        void publishStats_()
+        {
+            if (statsStream_)
+            {
+                stats_.writeJson(*statsStream_);
+            }
+        }
+
+        /**
+         * Count the allocations of the calling thread from here to stopAllocCount_(), into stats_.allocs.
+         */
+        void startAllocCount_()
+        {
+            allocStart_ = AllocStats::threadCounts();
+        }
+
+        void stopAllocCount_()
+        {
+            stats_.allocs = AllocStats::threadCounts() - allocStart_;
+        }
+
+        void startProgress_()
+        {
+            nextProgress_ = std::chrono::steady_clock::now() + progressInterval_;
+        }
+
+        /**
+         * True if a callback is set and the next progress report is due.
+         */
+        bool progressDue_()
+        {
+            if (!progress_)
+            {
+                return false;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (now < nextProgress_)
+            {
+                return false;
+            }
+            nextProgress_ = now + progressInterval_;
+            return true;
+        }
+
+        SearchStats stats_;
+        std::ostream* statsStream_ = nullptr;
+        ProgressCallback progress_;
+        std::chrono::milliseconds progressInterval_{ 500 };
+        std::chrono::steady_clock::time_point nextProgress_;
+        AllocCounts allocStart_;
     };
 }
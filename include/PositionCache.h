@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Connect4
+{
+    /**
+     * Results of earlier searches, shared by the threads of a GameService: position key -> best
+     * move and score, with the engine that found it and the effort it was given (the time budget).
+     *
+     * The table works like the one of ParallelPerft: fixed size, always replace, and lockless. Each
+     * entry stores key ^ data next to data, so an entry torn by concurrent writes fails the key
+     * check and is treated as a miss. Lookups are plain loads, so readers never wait for each other.
+     */
+    class PositionCache
+    {
+    public:
+
+        static constexpr int MAX_EFFORT = (1 << 20) - 1;
+
+        explicit PositionCache(size_t entries = 1 << 20); // rounded down to a power of 2
+
+        /**
+         * True if the position was searched by engine with at least effort.
+         */
+        bool probe(uint64_t key, int engine, int effort, int& column, double& score) const;
+        void store(uint64_t key, int engine, int effort, int column, double score);
+        void clear();
+
+    private:
+
+        struct Entry
+        {
+            std::atomic<uint64_t> check; // key ^ data
+            std::atomic<uint64_t> data;  // float score << 32 | effort << 12 | engine << 8 | column + 1
+        };
+
+        size_t index_(uint64_t key) const;
+
+        size_t hashMask_;
+        std::unique_ptr<Entry[]> table_;
+    };
+}
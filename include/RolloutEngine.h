@@ -0,0 +1,103 @@
+#pragma once
+#include "BitBoard.h"
+#include "FastRandom.h"
+#include "SimdRollout.h"
+
+namespace Connect4
+{
+    enum class RolloutPolicy : char
+    {
+        UNIFORM,  // uniformly random moves
+        TACTICAL, // win immediately if possible, else block the opponent's immediate win, else random
+    };
+
+    /**
+     * How MCTS values a new leaf, see BasicMctsAiPlayer::setLeafEvaluation.
+     */
+    enum class LeafEvaluation : char
+    {
+        ROLLOUT,    // playouts to the end of the game
+        TRUNCATED,  // playouts cut after a few plies, the position reached is scored by the heuristic
+        ALPHA_BETA, // shallow alpha-beta search over the heuristic, no playout
+    };
+
+    /**
+     * Random playouts (the MCTS default policy) on bitboards.
+     * A playout does not allocate: the position is a copy of a BitBoard, moves are picked
+     * straight from the possible-moves mask and only the mover's pieces are checked for a win.
+     */
+    class RolloutEngine
+    {
+    public:
+
+        explicit RolloutEngine(uint64_t seed = 0);
+        void seed(uint64_t seed);
+        void setPolicy(RolloutPolicy policy);
+        RolloutPolicy getPolicy() const;
+        void setSimdLanes(int lanes);
+
+        /**
+         * Play random moves until the game ends.
+         * Returns 1 if the AI wins, -1 if the human player wins and 0 for a tie.
+         * If finalBoard is given, it receives the position at the end of the playout.
+         * Compiled for BitBoard and WideBitBoard.
+         */
+        template <typename BoardT>
+        int rollout(const BoardT& board, bool isAiTurn, BoardT* finalBoard = nullptr);
+
+        /**
+         * Run count playouts from the same position and return the sum of the rewards.
+         * Uniform playouts on 64 bit four in a row boards go through the vector kernel
+         * (SimdRollout) in groups of simd lanes.
+         */
+        int rollouts(const BitBoard& board, bool isAiTurn, int count);
+        int rollouts(const WideBitBoard& board, bool isAiTurn, int count);
+
+        /**
+         * Playout cut after plies moves. Returns the result as rollout() does if the game ended
+         * before, +-1 if the player to move at the cutoff can win at once, else the heuristic
+         * value of the position reached (heuristicValue()).
+         */
+        template <typename BoardT>
+        double truncatedRollout(const BoardT& board, bool isAiTurn, int plies, BoardT* finalBoard = nullptr);
+
+        /**
+         * Alpha-beta search depth plies deep, scoring the positions at the horizon with
+         * BitBoard::windowScore(). Returns the value in [-1, 1] from the AI's point of view,
+         * +-1 for a forced win or loss within the horizon.
+         */
+        template <typename BoardT>
+        double alphaBeta(const BoardT& board, bool isAiTurn, int depth);
+
+        /**
+         * BitBoard::windowScore() of a position mapped to (-1, 1), on the scale of a rollout
+         * result: tanh(score / HEURISTIC_SCALE).
+         */
+        template <typename BoardT>
+        static double heuristicValue(const BoardT& board);
+
+        /**
+         * Pick one set bit of moves uniformly at random. moves must not be 0.
+         */
+        template <typename Mask>
+        Mask pickMove(Mask moves);
+
+    private:
+
+        static constexpr int UNFINISHED = 2;             // playout cut before the end of the game
+        static constexpr int WIN_SCORE = 1 << 20;        // alpha-beta score of a win, above any windowScore()
+        static constexpr double HEURISTIC_SCALE = 40.0;  // least squares fit of tanh(windowScore / scale) to 6x7 uniform playout means
+
+        template <typename BoardT>
+        int rolloutUniform_(BoardT& brd, bool isAiTurn, int maxPlies);
+        template <typename BoardT>
+        int rolloutTactical_(BoardT& brd, bool isAiTurn, int maxPlies);
+        template <typename BoardT>
+        int alphaBeta_(const BoardT& brd, bool isAiTurn, int depth, int alpha, int beta);
+
+        FastRandom rand_;
+        RolloutPolicy policy_;
+        SimdRollout simd_;
+        int simdLanes_; // 0 when the vector kernel is off
+    };
+}
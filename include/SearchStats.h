@@ -0,0 +1,40 @@
+#pragma once
+#include <iosfwd>
+#include <vector>
+#include "AllocStats.h"
+
+namespace Connect4
+{
+    /**
+     * What a player's search did for its last move. Counters that don't apply to an engine stay 0
+     * (cutoffs for MCTS, iterations and rollouts for minimax).
+     */
+    struct SearchStats
+    {
+        struct RootChild
+        {
+            int column;
+            long long visits; // MCTS: visits of the child, minimax: nodes searched below it
+            double score;     // MCTS: mean reward in [-1, 1], minimax: evaluation
+            bool bound;       // minimax: alpha-beta only bounds the score (every move but the best), it isn't written out
+        };
+
+        const char* engine = "";
+        int move = -1;           // column played, 0 based
+        double score = 0.0;      // of move for the player to move. MCTS: mean reward in [-1, 1], minimax: evaluation
+        long long nodes = 0;     // MCTS: nodes added to the tree, minimax: positions searched
+        long long leaves = 0;    // MCTS: iterations ending on a finished game, minimax: positions evaluated
+        long long cutoffs = 0;
+        long long iterations = 0;
+        long long rollouts = 0;
+        int maxDepth = 0;        // deepest ply below the root
+        int depth = 0;           // minimax: last iterative deepening depth searched to the end
+        double elapsedMs = 0.0;
+        double nodesPerSecond = 0.0;
+        std::vector<RootChild> rootChildren;
+        AllocCounts allocs;      // heap allocations of the search, if AllocStats::enabled()
+
+        void reset();
+        void writeJson(std::ostream& out) const;
+    };
+}
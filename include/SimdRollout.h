@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include "BitBoard.h"
+
+namespace Connect4
+{
+    /**
+     * Vectorized random playouts: 4, 8 or 16 independent games are advanced in lockstep, one
+     * bitboard per 64 bit vector lane (AVX2 holds 4 lanes per register, 8 and 16 lanes use 2 and 4
+     * registers to hide latency). Each lane has its own xoroshiro128+ generator. All lanes move at the
+     * same time, so the player to move and the move count are the same for every lane, and a lane
+     * whose game is over is masked off until the whole group is done.
+     *
+     * Move choice matches RolloutEngine's uniform policy: a column is drawn at random and drawn again
+     * if it is full, which is uniform over the playable columns.
+     *
+     * Without AVX2 (CONNECT4_AVX2 off, not an x86-64 build, or a CPU without it) the same kernel runs
+     * lane by lane. The CPU is checked at run time, only the AVX2 kernel is built with AVX2 code.
+     * Other connect lengths and boards wider than 64 bits go through RolloutEngine's scalar playouts.
+     */
+    class SimdRollout
+    {
+    public:
+
+        static constexpr int MAX_LANES = 16;
+
+        explicit SimdRollout(uint64_t seed = 0, int lanes = 8);
+        void seed(uint64_t seed);
+        void setLanes(int lanes);
+        int getLanes() const;
+
+        /**
+         * Run count playouts (rounded up to a multiple of the lane count) from board.
+         * Returns the summed rewards: +1 for every AI win, -1 for every human win.
+         */
+        int rollouts(const BitBoard& board, bool isAiTurn, int count);
+
+        /**
+         * True if the AVX2 kernel was compiled in and the CPU runs it.
+         */
+        static bool isVectorized();
+
+        /**
+         * True if the kernel handles board's variant: it only checks for four in a row.
+         */
+        static bool supports(const BitBoard& board)
+        {
+            return board.getConnect() == 4;
+        }
+
+    private:
+
+        template <int Lanes>
+        int rolloutGroup_(const BitBoard& board, bool isAiTurn); // the AVX2 kernel if isVectorized(), else the scalar one
+        template <int Lanes>
+        int rolloutGroupAvx2_(const BitBoard& board, bool isAiTurn);
+        template <int Lanes>
+        int rolloutGroupScalar_(const BitBoard& board, bool isAiTurn);
+
+        int lanes_;
+        uint64_t state0_[MAX_LANES];
+        uint64_t state1_[MAX_LANES];
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace Connect4
+{
+    /**
+     * Elo difference estimated from a match, with its 95% confidence interval.
+     */
+    struct EloEstimate
+    {
+        double elo = 0.0;
+        double low = 0.0;
+        double high = 0.0;
+    };
+
+    /**
+     * Sequential probability ratio test between two Elo hypotheses, H0: elo = elo0 and H1: elo = elo1
+     * (elo1 > elo0), with type I error alpha and type II error beta.
+     *
+     * The log likelihood ratio uses the normal approximation of the match score (the generalized SPRT
+     * used by engine testing frameworks), with the win, draw and loss frequencies observed so far:
+     *   LLR = (s1 - s0) * (2 * s - s0 - s1) / (2 * var(s))
+     * where s is the mean score per game and s0, s1 the scores expected at elo0 and elo1. Half a
+     * game of each result is added to the counts, so that a match without a single loss has a
+     * variance, and is decided, too.
+     * The test accepts H1 when the LLR reaches log((1 - beta) / alpha) and H0 when it falls to
+     * log(beta / (1 - alpha)).
+     */
+    class Sprt
+    {
+    public:
+
+        enum class Status : char
+        {
+            CONTINUE,
+            ACCEPT_H0,
+            ACCEPT_H1,
+        };
+
+        Sprt(double elo0 = 0.0, double elo1 = 5.0, double alpha = 0.05, double beta = 0.05);
+        double llr(int wins, int losses, int draws) const;
+        Status status(int wins, int losses, int draws) const;
+        double getLowerBound() const;
+        double getUpperBound() const;
+
+        static EloEstimate eloEstimate(int wins, int losses, int draws);
+
+    private:
+
+        double score0_; // expected score per game under H0
+        double score1_; // expected score per game under H1
+        double lowerBound_;
+        double upperBound_;
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include "Board.h"
+#include "GameRecord.h"
+#include "Player.h"
+#include "Sprt.h"
+
+namespace Connect4
+{
+    /**
+     * Result of a tournament, counted from the point of view of the AI player.
+     */
+    struct TournamentResult
+    {
+        int aiWins = 0;
+        int shadowWins = 0;
+        int ties = 0;
+        Sprt::Status sprtStatus = Sprt::Status::CONTINUE; // decision of the SPRT, if one was set
+
+        int games() const { return aiWins + shadowWins + ties; }
+    };
+
+    /**
+     * Plays many games between two engines on a pool of threads.
+     *
+     * The "AI" engine plays the AI_PLAYER markers and the "shadow" engine plays through flipped
+     * markers, as in the original simulation. Each worker thread creates its own pair of players
+     * from the factories (with its own seed), so engines never share state. Games are handed out
+     * through an atomic counter and results are summed in atomic counters; the calling thread only
+     * reads them to print a progress line every report interval.
+     * The first player alternates with the game number.
+     *
+     * With an SPRT set, the match stops as soon as the test accepts either hypothesis (games already
+     * being played are finished and counted); the number of games is then only an upper limit.
+     *
+     * With a record writer set, every game is written out with its moves and move times.
+     */
+    class Tournament
+    {
+    public:
+
+        using PlayerFactory = std::function<std::unique_ptr<Player>(int seed)>;
+
+        Tournament(PlayerFactory aiFactory, PlayerFactory shadowFactory);
+        void setNumGames(int numGames);
+        void setNumThreads(int numThreads); // 0 (default): one thread per hardware thread
+        void setSeed(int seed);
+        void setReportInterval(int milliseconds); // 0: no progress lines
+        void setSprt(const Sprt& sprt);
+        void setRecordWriter(GameRecordWriter* writer, uint16_t aiEngineId, uint16_t shadowEngineId);
+        void setBoardSize(int nRows, int nCols, int connect); // default 6x7, four in a row
+        TournamentResult run(std::ostream& out);
+
+    private:
+
+        void worker_(int workerIndex);
+        static Board::Markers playGame_(Board& board, Player& aiPlayer, Player& shadowPlayer, bool shadowFirst, GameRecord* record);
+        TournamentResult snapshot_() const;
+        void report_(std::ostream& out, const TournamentResult& result, double seconds) const;
+
+        PlayerFactory aiFactory_;
+        PlayerFactory shadowFactory_;
+        int numGames_;
+        int numThreads_;
+        int seed_;
+        int reportIntervalMs_;
+        bool useSprt_;
+        Sprt sprt_;
+        GameRecordWriter* recordWriter_;
+        uint16_t aiEngineId_;
+        uint16_t shadowEngineId_;
+        int nRows_;
+        int nCols_;
+        int connect_;
+
+        std::atomic<int> nextGame_;
+        std::atomic<int> aiWins_;
+        std::atomic<int> shadowWins_;
+        std::atomic<int> ties_;
+        std::atomic<bool> stop_; // set once the SPRT is decided
+    };
+}
@@ -0,0 +1,170 @@
+#include <cstdlib>
+#include <new>
+#include "AllocStats.h"
+
+namespace Connect4
+{
+#ifdef CONNECT4_ALLOC_STATS
+    //plain zero initialized thread locals: operator new must not allocate to reach them.
+    static thread_local int currentCategory = 0;
+    static thread_local long long threadAllocations[AllocCounts::NUM_CATEGORIES];
+    static thread_local long long threadBytes[AllocCounts::NUM_CATEGORIES];
+
+    AllocScope::AllocScope(AllocCategory category) : previous_{ currentCategory }
+    {
+        currentCategory = static_cast<int>(category);
+    }
+
+    AllocScope::~AllocScope()
+    {
+        currentCategory = previous_;
+    }
+#endif
+
+    long long AllocCounts::totalAllocations() const
+    {
+        long long total = 0;
+        for (int i = 0; i < NUM_CATEGORIES; i++)
+        {
+            total += allocations[i];
+        }
+        return total;
+    }
+
+    long long AllocCounts::totalBytes() const
+    {
+        long long total = 0;
+        for (int i = 0; i < NUM_CATEGORIES; i++)
+        {
+            total += bytes[i];
+        }
+        return total;
+    }
+
+    AllocCounts AllocCounts::operator-(const AllocCounts& earlier) const
+    {
+        AllocCounts difference;
+        for (int i = 0; i < NUM_CATEGORIES; i++)
+        {
+            difference.allocations[i] = allocations[i] - earlier.allocations[i];
+            difference.bytes[i] = bytes[i] - earlier.bytes[i];
+        }
+        return difference;
+    }
+
+    AllocCounts& AllocCounts::operator+=(const AllocCounts& other)
+    {
+        for (int i = 0; i < NUM_CATEGORIES; i++)
+        {
+            allocations[i] += other.allocations[i];
+            bytes[i] += other.bytes[i];
+        }
+        return *this;
+    }
+
+    const char* AllocCounts::categoryName(int category)
+    {
+        static const char* const NAMES[NUM_CATEGORIES] = { "other", "board", "tree", "rollout" };
+        return category >= 0 && category < NUM_CATEGORIES ? NAMES[category] : "";
+    }
+
+    bool AllocStats::enabled()
+    {
+#ifdef CONNECT4_ALLOC_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    AllocCounts AllocStats::threadCounts()
+    {
+        AllocCounts counts;
+#ifdef CONNECT4_ALLOC_STATS
+        for (int i = 0; i < AllocCounts::NUM_CATEGORIES; i++)
+        {
+            counts.allocations[i] = threadAllocations[i];
+            counts.bytes[i] = threadBytes[i];
+        }
+#endif
+        return counts;
+    }
+}
+
+#ifdef CONNECT4_ALLOC_STATS
+//The replaced allocation functions. They live next to threadCounts(), which every player calls, so
+//linking the engine library always brings them in. Aligned new (C++17) is left alone.
+void* operator new(std::size_t size)
+{
+    Connect4::threadAllocations[Connect4::currentCategory]++;
+    Connect4::threadBytes[Connect4::currentCategory] += static_cast<long long>(size);
+    for (;;)
+    {
+        void* p = std::malloc(size ? size : 1);
+        if (p)
+        {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return ::operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+#endif
+#endif
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <thread>
+#include "BatchAnalyzer.h"
+#include "Board.h"
+
+namespace Connect4
+{
+    BatchAnalyzer::BatchAnalyzer(PlayerFactory factory) : factory_{ factory }, numThreads_{ 0 }, seed_{ 0 }, window_{ 65536 },
+        nextRead_{ 0 }, nextWork_{ 0 }, nextWrite_{ 0 }, inputDone_{ false } {}
+
+    void BatchAnalyzer::setNumThreads(int numThreads)
+    {
+        numThreads_ = numThreads;
+    }
+
+    /**
+     * Worker i seeds its player with seed + i.
+     */
+    void BatchAnalyzer::setSeed(int seed)
+    {
+        seed_ = seed;
+    }
+
+    /**
+     * Rounded down to whole chunks, with at least two chunks so reading and writing overlap.
+     */
+    void BatchAnalyzer::setWindow(int positions)
+    {
+        assert(positions > 0);
+        window_ = positions;
+    }
+
+    /**
+     * Analyze every line of in and write the results to out. Blocks until the last line is written.
+     */
+    BatchResult BatchAnalyzer::run(std::istream& in, std::ostream& out)
+    {
+        ring_.assign(std::max(2, window_ / CHUNK_SIZE), Chunk());
+        for (Chunk& chunk : ring_)
+        {
+            chunk.lines.resize(CHUNK_SIZE);
+        }
+        nextRead_ = 0;
+        nextWork_ = 0;
+        nextWrite_ = 0;
+        inputDone_ = false;
+
+        int numThreads = numThreads_;
+        if (numThreads <= 0)
+        {
+            numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+
+        BatchResult result;
+        std::thread writer(&BatchAnalyzer::writer_, this, std::ref(out), std::ref(result));
+        std::vector<std::thread> workers;
+        for (int i = 0; i < numThreads; i++)
+        {
+            workers.emplace_back(&BatchAnalyzer::worker_, this, i);
+        }
+
+        const long long numSlots = static_cast<long long>(ring_.size());
+        bool moreInput = true;
+        while (moreInput)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            slotFree_.wait(lock, [&]() { return nextRead_ - nextWrite_ < numSlots; });
+            Chunk& chunk = ring_[nextRead_ % numSlots];
+            lock.unlock();
+
+            //the slot is nobody else's until nextRead_ moves past it.
+            chunk.numLines = 0;
+            while (chunk.numLines < CHUNK_SIZE && std::getline(in, chunk.lines[chunk.numLines]))
+            {
+                chunk.numLines++;
+            }
+            moreInput = chunk.numLines == CHUNK_SIZE;
+            if (chunk.numLines > 0)
+            {
+                lock.lock();
+                nextRead_++;
+                lock.unlock();
+                workAvailable_.notify_one();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inputDone_ = true;
+        }
+        workAvailable_.notify_all();
+        chunkDone_.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        writer.join();
+        return result;
+    }
+
+    void BatchAnalyzer::worker_(int workerIndex)
+    {
+        std::unique_ptr<Player> player = factory_(seed_ + workerIndex);
+        for (;;)
+        {
+            long long n;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                workAvailable_.wait(lock, [this]() { return nextWork_ < nextRead_ || inputDone_; });
+                if (nextWork_ == nextRead_)
+                {
+                    return;
+                }
+                n = nextWork_++;
+            }
+
+            Chunk& chunk = ring_[n % ring_.size()];
+            chunk.output.clear();
+            chunk.errors = 0;
+            for (int i = 0; i < chunk.numLines; i++)
+            {
+                analyze_(*player, chunk.lines[i], chunk);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                chunk.done = true;
+            }
+            chunkDone_.notify_one();
+        }
+    }
+
+    /**
+     * Print the finished chunks in input order.
+     */
+    void BatchAnalyzer::writer_(std::ostream& out, BatchResult& result)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            chunkDone_.wait(lock, [this]() {
+                return (nextWrite_ < nextRead_ && ring_[nextWrite_ % ring_.size()].done) || (inputDone_ && nextWrite_ == nextRead_);
+            });
+            if (nextWrite_ == nextRead_)
+            {
+                break;
+            }
+            Chunk& chunk = ring_[nextWrite_ % ring_.size()];
+            lock.unlock();
+            out << chunk.output;
+            result.positions += chunk.numLines;
+            result.errors += chunk.errors;
+            lock.lock();
+            chunk.done = false;
+            nextWrite_++;
+            slotFree_.notify_one();
+        }
+        out.flush();
+    }
+
+    void BatchAnalyzer::analyze_(Player& player, const std::string& line, Chunk& chunk)
+    {
+        std::string moves = line;
+        if (moves.empty() == false && moves.back() == '\r')
+        {
+            moves.pop_back();
+        }
+        chunk.output += moves;
+
+        Board board;
+        if (board.playMoves(moves) == false)
+        {
+            chunk.output += "\terror\n";
+            chunk.errors++;
+            return;
+        }
+        if (board.gameEnded())
+        {
+            chunk.output += "\tnone\n";
+            return;
+        }
+
+        player.play(board);
+        const SearchStats& stats = player.getSearchStats();
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "\t%d\t%.4g\n", stats.move + 1, stats.score);
+        chunk.output += buffer;
+    }
+}
@@ -0,0 +1,48 @@
+#include "BitBoard.h"
+
+namespace Connect4
+{
+    /**
+     * Empty bitboard. The board (plus one sentinel row) must fit in the mask, see fits().
+     */
+    template <typename MaskT>
+    BasicBitBoard<MaskT>::BasicBitBoard(size_t nRows, size_t nCols, int connect) : nRows_{ static_cast<int>(nRows) }, nCols_{ static_cast<int>(nCols) }, connect_{ connect }
+    {
+        //the longest shift, across connect - 1 diagonal steps, must stay inside the mask.
+        assert(fits(nRows, nCols) && connect_ >= 2 && (connect_ - 1) * (nRows_ + 2) < static_cast<int>(8 * sizeof(Mask)));
+        for (int c = 0; c < nCols_; c++)
+        {
+            bottomMask_ |= Mask(1) << (c * (nRows_ + 1));
+            boardMask_ |= columnMask(c);
+        }
+    }
+
+    /**
+     * Convert a Board into its bitboard representation.
+     */
+    template <typename MaskT>
+    BasicBitBoard<MaskT>::BasicBitBoard(const Board& board) : BasicBitBoard(board.getNumRows(), board.getNumCols(), board.getConnect())
+    {
+        const auto& cells = board.getBoard();
+        for (int r = 0; r < nRows_; r++)
+        {
+            for (int c = 0; c < nCols_; c++)
+            {
+                Mask bit = Mask(1) << (c * (nRows_ + 1) + r);
+                if (cells[r][c] == Board::Markers::AI_PLAYER)
+                {
+                    ai_ |= bit;
+                    numMoves_++;
+                }
+                else if (cells[r][c] == Board::Markers::HUMAN_PLAYER)
+                {
+                    human_ |= bit;
+                    numMoves_++;
+                }
+            }
+        }
+    }
+
+    template class BasicBitBoard<uint64_t>;
+    template class BasicBitBoard<Mask128>;
+}
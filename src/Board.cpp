@@ -5,16 +5,15 @@
 #include <algorithm>
 #include <iostream>
 #include "Board.h"
-#include "Globals.h"
 
 namespace Connect4
 {
-    Board::Board(size_t nRows, size_t nCols) : nRows_{ nRows }, nCols_{ nCols }, board_(nRows_, std::vector<Markers>(nCols_, Markers::NONE)), validLocations_(nCols_) {}
+    Board::Board(size_t nRows, size_t nCols, int connect) : nCols_{ nCols }, nRows_{ nRows }, connect_{ connect }, board_(nRows_, std::vector<Markers>(nCols_, Markers::NONE)), validLocations_(nCols_) {}
 
     /**
      * For testing only - start with a specified board configuration
      */
-    Board::Board(std::vector<std::vector<Markers>>& board) : board_{ board }, validLocations_(board[0].size())
+    Board::Board(std::vector<std::vector<Markers>>& board) : connect_{ CONNECT_SIZE }, board_{ board }, validLocations_(board[0].size())
     {
         nRows_ = board_.size();
         nCols_ = board_[0].size();
@@ -47,19 +46,56 @@ namespace Connect4
         return nRows_;
     }
 
+    /**
+     * Get the number of pieces in a row that wins.
+     */
+    int Board::getConnect() const
+    {
+        return connect_;
+    }
+
     /**
      * Checks if there is a winner based on the current board state.
      * The winner can be AI_PLAYER, HUMAN_PLAYER or NONE (if the game is a tie, or if it is still in progress)
      */
     Board::Markers Board::getWinner() const
     {
+        //four in a row gets its own copy with the line length known at compile time, so the checks unroll.
+        return connect_ == 4 ? winner_<4>() : winner_<0>();
+    }
+
+    /**
+     * getWinner() for lines of Connect pieces, or connect_ pieces if Connect is 0.
+     */
+    template <int Connect>
+    Board::Markers Board::winner_() const
+    {
+        const int connect = Connect > 0 ? Connect : connect_;
+        const int nRows = static_cast<int>(nRows_);
+        const int nCols = static_cast<int>(nCols_);
+
+        //the marker at (r, c) if the connect cells stepping by (dr, dc) all hold it, NONE otherwise.
+        //The caller keeps the line on the board.
+        auto lineAt = [this, connect](int r, int c, int dr, int dc)
+        {
+            auto marker = board_[r][c];
+            for (int k = 1; k < connect && marker != Markers::NONE; k++)
+            {
+                if (board_[r + k * dr][c + k * dc] != marker)
+                {
+                    marker = Markers::NONE;
+                }
+            }
+            return marker;
+        };
+
         // Check diagonal oriented '/'
-        for (int r = 0; r <= nRows_ - CONNECT_SIZE; r++)
+        for (int r = 0; r <= nRows - connect; r++)
         {
-            for (int c = 0; c <= nCols_ - CONNECT_SIZE; c++)
+            for (int c = 0; c <= nCols - connect; c++)
             {
-                auto marker = board_[r][c];
-                if (marker != Markers::NONE && marker == board_[r + 1][c + 1] && marker == board_[r + 2][c + 2] && marker == board_[r + 3][c + 3])
+                auto marker = lineAt(r, c, 1, 1);
+                if (marker != Markers::NONE)
                 {
                     return marker;
                 }
@@ -67,12 +103,12 @@ namespace Connect4
         }
 
         // Check diagonal oriented '\'
-        for (int r = 0; r <= nRows_ - CONNECT_SIZE; r++)
+        for (int r = 0; r <= nRows - connect; r++)
         {
-            for (int c = CONNECT_SIZE - 1; c < nCols_; c++)
+            for (int c = connect - 1; c < nCols; c++)
             {
-                auto marker = board_[r][c];
-                if (marker != Markers::NONE && marker == board_[r + 1][c - 1] && marker == board_[r + 2][c - 2] && marker == board_[r + 3][c - 3])
+                auto marker = lineAt(r, c, 1, -1);
+                if (marker != Markers::NONE)
                 {
                     return marker;
                 }
@@ -80,12 +116,12 @@ namespace Connect4
         }
 
         // Check rows (horizontal)
-        for (int r = 0; r < nRows_; r++)
+        for (int r = 0; r < nRows; r++)
         {
-            for (int c = 0; c <= nCols_ - CONNECT_SIZE; c++)
+            for (int c = 0; c <= nCols - connect; c++)
             {
-                auto marker = board_[r][c];
-                if (marker != Markers::NONE && marker == board_[r][c + 1] && marker == board_[r][c + 2] && marker == board_[r][c + 3])
+                auto marker = lineAt(r, c, 0, 1);
+                if (marker != Markers::NONE)
                 {
                     return marker;
                 }
@@ -93,12 +129,12 @@ namespace Connect4
         }
 
         // Check columns (vertical)
-        for (int r = 0; r <= nRows_ - CONNECT_SIZE; r++)
+        for (int r = 0; r <= nRows - connect; r++)
         {
-            for (int c = 0; c < nCols_; c++)
+            for (int c = 0; c < nCols; c++)
             {
-                auto marker = board_[r][c];
-                if (marker != Markers::NONE && marker == board_[r + 1][c] && marker == board_[r + 2][c] && marker == board_[r + 3][c])
+                auto marker = lineAt(r, c, 1, 0);
+                if (marker != Markers::NONE)
                 {
                     return marker;
                 }
@@ -241,6 +277,28 @@ namespace Connect4
         }
     }
 
+    /**
+     * Play a move string: the columns played, '1' for the leftmost column, players alternating.
+     * The markers are assigned so that the player to move afterwards is AI_PLAYER, the side the AIs
+     * play. Returns false (leaving the board partly played) if a column is invalid or full, or if
+     * a move is made after the game ended.
+     */
+    bool Board::playMoves(const std::string& moves)
+    {
+        bool aiMoves = (moves.size() % 2) == 0;
+        for (char ch : moves)
+        {
+            int col = ch - '1';
+            if (col < 0 || col >= static_cast<int>(nCols_) || validLocations_[col] >= static_cast<int>(nRows_) || gameEnded())
+            {
+                return false;
+            }
+            dropPiece(col, aiMoves ? Markers::AI_PLAYER : Markers::HUMAN_PLAYER);
+            aiMoves = !aiMoves;
+        }
+        return true;
+    }
+
     /**
      * Return the vector representing the board.
      */
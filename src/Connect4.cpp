@@ -2,7 +2,7 @@
 
 int main()
 {
-    Connect4::GameController gameController(false);
+    Connect4::GameController gameController;
     gameController.run();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Board.h"
+#include "BitBoard.h"
+#include "MctsAiPlayer.h"
+#include "MiniMaxAiPlayer.h"
+#include "RolloutEngine.h"
+
+/**
+ * Engine benchmarks on a fixed corpus of positions.
+ *
+ *   Connect4Bench [--min-time MS] [--max-depth D] [--iterations I]
+ *
+ * Prints one tab separated line per measurement: benchmark, position, value, unit. Micro benchmarks
+ * repeat an operation for at least --min-time milliseconds (default 200) and report ns/op; macro
+ * benchmarks run minimax at depths 2, 4, ... up to --max-depth (default 8) and MCTS at 1000 and
+ * --iterations (default 10000) iterations per move.
+ *
+ * Besides the standard 6x7 board, the corpus has connect-5 positions on 7x8 (still a 64 bit
+ * BitBoard) and 8x9 (a 128 bit WideBitBoard), named after the variant.
+ */
+namespace Connect4
+{
+    namespace
+    {
+        struct Position
+        {
+            const char* name;
+            const char* moves; // columns from 1, see Board::playMoves
+            int rows;
+            int cols;
+            int connect;
+        };
+
+        //positions from the opening to the endgame, none of them over. The AI player is to move.
+        const Position CORPUS[] = {
+            { "empty", "", 6, 7, 4 },
+            { "opening", "4453", 6, 7, 4 },
+            { "early", "15243522", 6, 7, 4 },
+            { "middle", "1524352213355", 6, 7, 4 },
+            { "late", "15243522133556736", 6, 7, 4 },
+            { "endgame", "152435221335567362667767", 6, 7, 4 },
+            { "7x8c5.opening", "467335", 7, 8, 5 },
+            { "7x8c5.middle", "55456761637644762354", 7, 8, 5 },
+            { "7x8c5.late", "3615884451254234258635417666716334486357", 7, 8, 5 },
+            { "8x9c5.opening", "453554", 8, 9, 5 },
+            { "8x9c5.middle", "63443466173443888586", 8, 9, 5 },
+            { "8x9c5.late", "2754459286335573574514625484182671372844", 8, 9, 5 },
+        };
+
+        //keeps the compiler from optimizing the measured calls away.
+        volatile long long sink = 0;
+
+        double secondsSince(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void print(const std::string& benchmark, const char* position, double value, const char* unit)
+        {
+            std::cout << benchmark << '\t' << position << '\t' << value << '\t' << unit << '\n';
+        }
+
+        /**
+         * Nanoseconds per operation of op, which does opsPerCall operations per call.
+         */
+        template <typename Op>
+        double nsPerOp(Op op, int opsPerCall, double minSeconds)
+        {
+            long long calls = 0;
+            auto start = std::chrono::steady_clock::now();
+            do
+            {
+                for (int i = 0; i < 64; i++)
+                {
+                    op();
+                }
+                calls += 64;
+            } while (secondsSince(start) < minSeconds);
+            return secondsSince(start) * 1e9 / (static_cast<double>(calls) * opsPerCall);
+        }
+
+        template <typename BoardT>
+        void rolloutBenchmarks(const Position& position, const BoardT& bitBoard, double minSeconds)
+        {
+            RolloutEngine engine(1);
+            engine.setSimdLanes(0);
+            print("rollout.scalar", position.name, nsPerOp([&]() { sink = sink + engine.rollout(bitBoard, true); }, 1, minSeconds), "ns/op");
+
+            //the vector kernel only takes 64 bit four in a row boards.
+            if (std::is_same<BoardT, BitBoard>::value && position.connect == 4)
+            {
+                engine.setSimdLanes(8);
+                print("rollout.batch8", position.name, nsPerOp([&]() { sink = sink + engine.rollouts(bitBoard, true, 64); }, 64, minSeconds), "ns/op");
+            }
+
+            //the hybrid MCTS leaf evaluations, at the Connect4Cli simulate default plies.
+            print("bitboard.windowScore", position.name, nsPerOp([&]() { sink = sink + bitBoard.windowScore(); }, 1, minSeconds), "ns/op");
+            print("rollout.truncated16", position.name, nsPerOp([&]() { sink = sink + static_cast<long long>(engine.truncatedRollout(bitBoard, true, 16) * 1000.0); }, 1, minSeconds), "ns/op");
+            print("leaf.alphabeta2", position.name, nsPerOp([&]() { sink = sink + static_cast<long long>(engine.alphaBeta(bitBoard, true, 2) * 1000.0); }, 1, minSeconds), "ns/op");
+        }
+
+        void microBenchmarks(const Position& position, const Board& board, double minSeconds)
+        {
+            //dropPiece: fill every column, then restore the position (a copy into a board of the
+            //same size, which doesn't allocate). The restore is included in the time per drop.
+            Board scratch = board;
+            int drops = 0;
+            for (int col : board.getMoves())
+            {
+                drops += static_cast<int>(board.getNumRows()) - col;
+            }
+            print("board.dropPiece", position.name, nsPerOp([&]() {
+                for (int col = 0; col < static_cast<int>(scratch.getNumCols()); col++)
+                {
+                    while (scratch.getMoves()[col] < static_cast<int>(scratch.getNumRows()))
+                    {
+                        scratch.dropPiece(col, Board::Markers::AI_PLAYER);
+                    }
+                }
+                scratch = board;
+            }, drops, minSeconds), "ns/op");
+
+            print("board.getWinner", position.name, nsPerOp([&]() { sink = sink + static_cast<int>(board.getWinner()); }, 1, minSeconds), "ns/op");
+            print("board.gameEnded", position.name, nsPerOp([&]() { sink = sink + board.gameEnded(); }, 1, minSeconds), "ns/op");
+            print("board.copy", position.name, nsPerOp([&]() { Board copy = board; sink = sink + copy.getMoves()[0]; }, 1, minSeconds), "ns/op");
+
+            MiniMaxAiPlayer miniMax(1);
+            print("minimax.evaluate", position.name, nsPerOp([&]() { sink = sink + miniMax.evaluate(board); }, 1, minSeconds), "ns/op");
+
+            if (BitBoard::fits(board.getNumRows(), board.getNumCols()))
+            {
+                rolloutBenchmarks(position, BitBoard(board), minSeconds);
+            }
+            else
+            {
+                rolloutBenchmarks(position, WideBitBoard(board), minSeconds);
+            }
+        }
+
+        void macroBenchmarks(const Position& position, const Board& board, int maxDepth, int iterations)
+        {
+            for (int depth = 2; depth <= maxDepth; depth += 2)
+            {
+                MiniMaxAiPlayer miniMax(depth);
+                Board copy = board;
+                auto start = std::chrono::steady_clock::now();
+                miniMax.play(copy);
+                const double seconds = secondsSince(start);
+                const std::string name = "minimax.depth" + std::to_string(depth);
+                print(name, position.name, seconds * 1000.0, "ms");
+                const SearchStats& stats = miniMax.getSearchStats();
+                print(name, position.name, static_cast<double>(stats.nodes), "nodes");
+                print(name, position.name, stats.nodes / seconds, "nodes/s");
+                print(name, position.name, static_cast<double>(stats.cutoffs), "cutoffs");
+            }
+
+            const int iterationCounts[] = { 1000, iterations };
+            for (int count : iterationCounts)
+            {
+                //a proven position can end the search early, the rates use the iterations actually run.
+                std::unique_ptr<Player> mcts = makeMctsPlayer(board.getNumRows(), board.getNumCols(), count, 1);
+                Board copy = board;
+                auto start = std::chrono::steady_clock::now();
+                mcts->play(copy);
+                const double seconds = secondsSince(start);
+                const SearchStats& stats = mcts->getSearchStats();
+                const std::string name = "mcts.iterations" + std::to_string(count);
+                print(name, position.name, seconds * 1000.0, "ms");
+                print(name, position.name, stats.iterations / seconds, "iterations/s");
+                print(name, position.name, stats.rollouts / seconds, "rollouts/s");
+                print(name, position.name, stats.nodes / seconds, "nodes/s");
+            }
+        }
+
+        int intOption(const std::map<std::string, std::string>& options, const std::string& name, int defaultValue)
+        {
+            auto it = options.find(name);
+            return it == options.end() ? defaultValue : std::atoi(it->second.c_str());
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace Connect4;
+    std::map<std::string, std::string> options;
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string name = argv[i];
+        if (name.compare(0, 2, "--") != 0 || i + 1 >= argc)
+        {
+            std::cerr << "usage: Connect4Bench [--min-time MS] [--max-depth D] [--iterations I]\n";
+            return 1;
+        }
+        options[name.substr(2)] = argv[i + 1];
+    }
+    const double minSeconds = intOption(options, "min-time", 200) / 1000.0;
+    const int maxDepth = intOption(options, "max-depth", 8);
+    const int iterations = intOption(options, "iterations", 10000);
+
+    std::cout << "benchmark\tposition\tvalue\tunit\n";
+    for (const Position& position : CORPUS)
+    {
+        Board board(position.rows, position.cols, position.connect);
+        if (board.playMoves(position.moves) == false || board.gameEnded())
+        {
+            std::cerr << "bad corpus position " << position.name << "\n";
+            return 1;
+        }
+        microBenchmarks(position, board, minSeconds);
+        macroBenchmarks(position, board, maxDepth, iterations);
+    }
+    std::cout.flush();
+    return 0;
+}
@@ -0,0 +1,649 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include "AllocStats.h"
+#include "BatchAnalyzer.h"
+#include "Board.h"
+#include "BitBoard.h"
+#include "EngineServer.h"
+#include "GameRecord.h"
+#include "GameService.h"
+#include "LoadGenerator.h"
+#include "MctsAiPlayer.h"
+#include "MiniMaxAiPlayer.h"
+#include "OpeningBook.h"
+#include "Perft.h"
+#include "RolloutEngine.h"
+#include "Tournament.h"
+
+/**
+ * Headless front end of the engine library, for build and compute hosts without a display.
+ *
+ *   Connect4Cli simulate [--games N] [--threads T] [--seed S] [--mcts-iterations I] [--minimax-depth D]
+ *                        [--rows R --cols C --connect K] [--mcts-leaf rollout|truncated|alphabeta [--mcts-leaf-plies P]]
+ *                        [--sprt-elo0 E0 --sprt-elo1 E1 [--sprt-alpha A] [--sprt-beta B]] [--record FILE]
+ *   Connect4Cli bench [--seconds S] [--mcts-iterations I] [--minimax-depth D]
+ *   Connect4Cli analyze --moves 4453 [--mcts-iterations I] [--minimax-depth D]
+ *   Connect4Cli records --file FILE
+ *   Connect4Cli perft --depth N [--moves 4453] [--mode board|bitboard] [--threads T]
+ *   Connect4Cli serve [--mcts-iterations I] [--minimax-depth D]
+ *   Connect4Cli batch --file FILE [--output FILE] [--engine mcts|minimax] [--mcts-iterations I] [--minimax-depth D] [--threads T] [--window W]
+ *   Connect4Cli loadtest [--clients N] [--threads T] [--engine mcts|minimax] [--budget MS] [--think MS] [--seconds S]
+ *                        [--book FILE] [--minimax-depth D] [--seed S]
+ *   Connect4Cli allocs [--games N] [--mcts-iterations I] [--minimax-depth D] [--max-allocs A] [--max-bytes B] [--warmup W]
+ *
+ * Moves are the columns played from the empty board, 1 to 7, first player first.
+ */
+namespace Connect4
+{
+    namespace
+    {
+        using Options = std::map<std::string, std::string>;
+
+        //engine ids in game records.
+        constexpr uint16_t ENGINE_MCTS = 1;
+        constexpr uint16_t ENGINE_MINIMAX = 2;
+
+        int usage()
+        {
+            std::cerr << "usage: Connect4Cli simulate [--games N] [--threads T] [--seed S] [--mcts-iterations I] [--minimax-depth D]\n"
+                << "                            [--rows R --cols C --connect K] [--mcts-leaf rollout|truncated|alphabeta [--mcts-leaf-plies P]]\n"
+                << "                            [--sprt-elo0 E0 --sprt-elo1 E1 [--sprt-alpha A] [--sprt-beta B]] [--record FILE]\n"
+                << "       Connect4Cli bench [--seconds S] [--mcts-iterations I] [--minimax-depth D]\n"
+                << "       Connect4Cli analyze --moves <columns 1-7> [--mcts-iterations I] [--minimax-depth D]\n"
+                << "       Connect4Cli records --file FILE\n"
+                << "       Connect4Cli perft --depth N [--moves <columns 1-7>] [--mode board|bitboard] [--threads T]\n"
+                << "       Connect4Cli serve [--mcts-iterations I] [--minimax-depth D]\n"
+                << "       Connect4Cli batch --file FILE [--output FILE] [--engine mcts|minimax] [--mcts-iterations I] [--minimax-depth D] [--threads T] [--window W]\n"
+                << "       Connect4Cli loadtest [--clients N] [--threads T] [--engine mcts|minimax] [--budget MS] [--think MS] [--seconds S]\n"
+                << "                            [--book FILE] [--minimax-depth D] [--seed S]\n"
+                << "       Connect4Cli allocs [--games N] [--mcts-iterations I] [--minimax-depth D] [--max-allocs A] [--max-bytes B] [--warmup W]\n";
+            return 1;
+        }
+
+        /**
+         * Parse "--name value" pairs. Returns false on anything else.
+         */
+        bool parseOptions(int argc, char* argv[], int first, Options& options)
+        {
+            for (int i = first; i < argc; i += 2)
+            {
+                std::string name = argv[i];
+                if (name.compare(0, 2, "--") != 0 || i + 1 >= argc)
+                {
+                    return false;
+                }
+                options[name.substr(2)] = argv[i + 1];
+            }
+            return true;
+        }
+
+        int intOption(const Options& options, const std::string& name, int defaultValue)
+        {
+            auto it = options.find(name);
+            return it == options.end() ? defaultValue : std::atoi(it->second.c_str());
+        }
+
+        double doubleOption(const Options& options, const std::string& name, double defaultValue)
+        {
+            auto it = options.find(name);
+            return it == options.end() ? defaultValue : std::atof(it->second.c_str());
+        }
+
+        /**
+         * --mcts-leaf, see BasicMctsAiPlayer::setLeafEvaluation. Returns false on an unknown name.
+         */
+        bool leafOption(const Options& options, LeafEvaluation& leafEvaluation)
+        {
+            auto it = options.find("mcts-leaf");
+            leafEvaluation = LeafEvaluation::ROLLOUT;
+            if (it == options.end() || it->second == "rollout")
+            {
+                return true;
+            }
+            if (it->second == "truncated")
+            {
+                leafEvaluation = LeafEvaluation::TRUNCATED;
+                return true;
+            }
+            if (it->second == "alphabeta")
+            {
+                leafEvaluation = LeafEvaluation::ALPHA_BETA;
+                return true;
+            }
+            return false;
+        }
+
+        template <typename BoardT>
+        std::unique_ptr<Player> mctsPlayer(int iterations, int seed, LeafEvaluation leafEvaluation, int leafPlies)
+        {
+            BasicMctsAiPlayer<BoardT>* player = new BasicMctsAiPlayer<BoardT>(iterations, seed);
+            player->setLeafEvaluation(leafEvaluation, leafPlies);
+            return std::unique_ptr<Player>(player);
+        }
+
+        double secondsSince(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        /**
+         * Column (0 based) in which player dropped a piece on board.
+         */
+        int playedColumn(Player& player, Board& board)
+        {
+            const std::vector<int> before = board.getMoves();
+            player.play(board);
+            for (size_t c = 0; c < before.size(); c++)
+            {
+                if (board.getMoves()[c] != before[c])
+                {
+                    return static_cast<int>(c);
+                }
+            }
+            return -1;
+        }
+
+        int simulate(const Options& options)
+        {
+            const int iterations = intOption(options, "mcts-iterations", 5000);
+            const int depth = intOption(options, "minimax-depth", 8);
+            const int rows = intOption(options, "rows", 6);
+            const int cols = intOption(options, "cols", 7);
+            const int connect = intOption(options, "connect", CONNECT_SIZE);
+            if (rows < 1 || cols < 1 || connect < 2 || (rows < connect && cols < connect) || WideBitBoard::fits(rows, cols) == false)
+            {
+                std::cerr << "simulate: the board must fit in 128 bits and hold connect in a row\n";
+                return 1;
+            }
+            LeafEvaluation leafEvaluation;
+            const bool leafOk = leafOption(options, leafEvaluation);
+            const int leafPlies = intOption(options, "mcts-leaf-plies", leafEvaluation == LeafEvaluation::ALPHA_BETA ? 2 : 16);
+            if (leafOk == false || leafPlies < 0)
+            {
+                std::cerr << "simulate: --mcts-leaf must be rollout, truncated or alphabeta, with --mcts-leaf-plies >= 0\n";
+                return 1;
+            }
+            Tournament tournament(
+                [iterations, rows, cols, leafEvaluation, leafPlies](int seed)
+                {
+                    return BitBoard::fits(rows, cols) ? mctsPlayer<BitBoard>(iterations, seed, leafEvaluation, leafPlies) :
+                        mctsPlayer<WideBitBoard>(iterations, seed, leafEvaluation, leafPlies);
+                },
+                [depth](int) { return std::unique_ptr<Player>(new MiniMaxAiPlayer(depth)); });
+            tournament.setBoardSize(rows, cols, connect);
+            tournament.setNumGames(intOption(options, "games", 10000));
+            tournament.setNumThreads(intOption(options, "threads", 0));
+            tournament.setSeed(intOption(options, "seed", 0));
+
+            //with an SPRT, --games is the most games to play before giving up.
+            if (options.count("sprt-elo0") || options.count("sprt-elo1"))
+            {
+                const double elo0 = doubleOption(options, "sprt-elo0", 0.0);
+                const double elo1 = doubleOption(options, "sprt-elo1", 5.0);
+                const double alpha = doubleOption(options, "sprt-alpha", 0.05);
+                const double beta = doubleOption(options, "sprt-beta", 0.05);
+                if (elo0 >= elo1 || alpha <= 0.0 || alpha >= 1.0 || beta <= 0.0 || beta >= 1.0)
+                {
+                    std::cerr << "simulate: the SPRT needs elo0 < elo1 and alpha, beta in (0, 1)\n";
+                    return 1;
+                }
+                tournament.setSprt(Sprt(elo0, elo1, alpha, beta));
+            }
+
+            std::unique_ptr<GameRecordWriter> writer;
+            auto recordFile = options.find("record");
+            if (recordFile != options.end())
+            {
+                writer.reset(new GameRecordWriter(recordFile->second));
+                if (writer->isOpen() == false)
+                {
+                    std::cerr << "simulate: cannot open " << recordFile->second << "\n";
+                    return 1;
+                }
+                tournament.setRecordWriter(writer.get(), ENGINE_MCTS, ENGINE_MINIMAX);
+            }
+            tournament.run(std::cout);
+            return 0;
+        }
+
+        int bench(const Options& options)
+        {
+            const int seconds = intOption(options, "seconds", 1);
+            const int iterations = intOption(options, "mcts-iterations", 20000);
+            const int depth = intOption(options, "minimax-depth", 8);
+
+            //raw playout speed from the empty board.
+            RolloutEngine engine(1);
+            BitBoard empty(6, 7);
+            long long numRollouts = 0;
+            auto start = std::chrono::steady_clock::now();
+            while (secondsSince(start) < seconds)
+            {
+                engine.rollouts(empty, true, 1024);
+                numRollouts += 1024;
+            }
+            std::cout << "rollouts/s:        " << numRollouts / secondsSince(start) << "\n";
+
+            Board board;
+            MctsAiPlayer mcts(iterations, 1);
+            start = std::chrono::steady_clock::now();
+            mcts.play(board);
+            std::cout << "mcts iterations/s: " << iterations / secondsSince(start) << "\n";
+
+            //the hybrid leaf evaluations, at the simulate defaults.
+            const LeafEvaluation hybrids[] = { LeafEvaluation::TRUNCATED, LeafEvaluation::ALPHA_BETA };
+            const int hybridPlies[] = { 16, 2 };
+            const char* hybridNames[] = { "truncated", "alphabeta" };
+            for (int i = 0; i < 2; i++)
+            {
+                board.reset();
+                MctsAiPlayer hybrid(iterations, 1);
+                hybrid.setLeafEvaluation(hybrids[i], hybridPlies[i]);
+                start = std::chrono::steady_clock::now();
+                hybrid.play(board);
+                std::cout << "mcts " << hybridNames[i] << " iterations/s: " << iterations / secondsSince(start) << "\n";
+            }
+
+            board.reset();
+            MiniMaxAiPlayer miniMax(depth);
+            start = std::chrono::steady_clock::now();
+            miniMax.play(board);
+            std::cout << "minimax depth " << depth << ":   " << secondsSince(start) * 1000.0 << " ms\n";
+            return 0;
+        }
+
+        int analyze(const Options& options)
+        {
+            auto moves = options.find("moves");
+            Board board;
+            if (moves == options.end() || board.playMoves(moves->second) == false)
+            {
+                std::cerr << "analyze: --moves must be a legal sequence of columns 1-7\n";
+                return 1;
+            }
+            board.print();
+            if (board.gameEnded())
+            {
+                std::cout << "game over\n";
+                return 0;
+            }
+            std::cout << "to move: o\n";
+
+            MctsAiPlayer mcts(intOption(options, "mcts-iterations", 20000), 1);
+            MiniMaxAiPlayer miniMax(intOption(options, "minimax-depth", 8));
+            Player* players[] = { &mcts, &miniMax };
+            const char* names[] = { "mcts", "minimax" };
+            for (int i = 0; i < 2; i++)
+            {
+                Board copy = board;
+                auto start = std::chrono::steady_clock::now();
+                int col = playedColumn(*players[i], copy);
+                std::cout << names[i] << ": column " << col + 1 << " (" << secondsSince(start) * 1000.0 << " ms)\n";
+                players[i]->getSearchStats().writeJson(std::cout);
+            }
+            return 0;
+        }
+
+        /**
+         * Summary of a game record file: results, game length, time per move of each engine and
+         * the first player's score for every opening move.
+         */
+        int records(const Options& options)
+        {
+            auto file = options.find("file");
+            if (file == options.end())
+            {
+                return usage();
+            }
+            GameRecordReader reader(file->second);
+            if (reader.isOpen() == false)
+            {
+                std::cerr << "records: cannot read " << file->second << "\n";
+                return 1;
+            }
+
+            long long games = 0, aiWins = 0, shadowWins = 0, totalMoves = 0;
+            double aiTimeUs = 0.0, shadowTimeUs = 0.0;
+            long long aiMoves = 0, shadowMoves = 0;
+            std::map<std::string, long long> boards; // "6x7 connect 4" -> games
+            std::map<std::pair<std::string, int>, std::pair<long long, double>> openings; // board, first column -> games, first player's score
+            for (const GameRecordView& game : reader)
+            {
+                const GameRecordHeader& header = *game.header;
+                const std::string boardName = std::to_string(header.numRows) + "x" + std::to_string(header.numCols) + " connect " + std::to_string(header.connect);
+                games++;
+                boards[boardName]++;
+                aiWins += header.result > 0;
+                shadowWins += header.result < 0;
+                totalMoves += header.numMoves;
+
+                const bool shadowFirst = (header.flags & GameRecordHeader::SHADOW_FIRST) != 0;
+                for (int i = 0; i < header.numMoves; i++)
+                {
+                    const bool shadowMove = ((i % 2) == 0) == shadowFirst;
+                    (shadowMove ? shadowTimeUs : aiTimeUs) += game.moveTimesUs[i];
+                    (shadowMove ? shadowMoves : aiMoves)++;
+                }
+                if (header.numMoves > 0)
+                {
+                    const int firstPlayerResult = shadowFirst ? -header.result : header.result;
+                    auto& opening = openings[std::make_pair(boardName, static_cast<int>(game.moves[0]))];
+                    opening.first++;
+                    opening.second += (firstPlayerResult + 1) / 2.0;
+                }
+            }
+
+            std::cout << "games:            " << games << "\n"
+                << "ai wins:          " << aiWins << "\n"
+                << "shadow wins:      " << shadowWins << "\n"
+                << "ties:             " << games - aiWins - shadowWins << "\n"
+                << "moves per game:   " << (games ? static_cast<double>(totalMoves) / games : 0.0) << "\n"
+                << "ai us/move:       " << (aiMoves ? aiTimeUs / aiMoves : 0.0) << "\n"
+                << "shadow us/move:   " << (shadowMoves ? shadowTimeUs / shadowMoves : 0.0) << "\n";
+            for (const auto& board : boards)
+            {
+                std::cout << "board " << board.first << ": " << board.second << " games\n";
+            }
+            for (const auto& opening : openings)
+            {
+                std::cout << "opening " << opening.first.second + 1 << " (" << opening.first.first << "): " << opening.second.first
+                    << " games, first player score " << 100.0 * opening.second.second / opening.second.first << " %\n";
+            }
+            return 0;
+        }
+
+        /**
+         * Perft for depths 1 to --depth. From the empty board, the counts are checked against the
+         * known ones and a mismatch fails the command.
+         */
+        int runPerft(const Options& options)
+        {
+            const int depth = intOption(options, "depth", 8);
+            auto moves = options.find("moves");
+            Board board;
+            if (moves != options.end() && board.playMoves(moves->second) == false)
+            {
+                std::cerr << "perft: --moves must be a legal sequence of columns 1-7\n";
+                return 1;
+            }
+            const bool fromEmpty = moves == options.end() || moves->second.empty();
+            auto mode = options.find("mode");
+            const bool useBoard = mode != options.end() && mode->second == "board";
+            ParallelPerft parallelPerft(intOption(options, "threads", 0));
+
+            int status = 0;
+            for (int d = 1; d <= depth; d++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                const long long nodes = useBoard ? perft(board, d) : parallelPerft.count(BitBoard(board), d, true);
+                const double seconds = secondsSince(start);
+                std::cout << "depth " << d << "\tnodes " << nodes << "\tms " << seconds * 1000.0 << "\tnodes/s " << nodes / std::max(seconds, 1e-9);
+                if (fromEmpty && d < ParallelPerft::NUM_KNOWN_COUNTS)
+                {
+                    const bool ok = nodes == ParallelPerft::KNOWN_COUNTS[d];
+                    std::cout << (ok ? "\tok" : "\tMISMATCH");
+                    status = ok ? status : 1;
+                }
+                std::cout << "\n";
+            }
+            return status;
+        }
+
+        /**
+         * Engine protocol on stdin/stdout, see EngineServer. The options are the defaults of go.
+         */
+        int serve(const Options& options)
+        {
+            EngineServer server;
+            server.setDefaultIterations(std::max(1, intOption(options, "mcts-iterations", 20000)));
+            server.setDefaultDepth(std::max(1, intOption(options, "minimax-depth", 8)));
+            return server.run(std::cin, std::cout);
+        }
+
+        /**
+         * Best move and score of every position in a file (one move sequence per line, - for
+         * stdin), in input order. See BatchAnalyzer.
+         */
+        int batch(const Options& options)
+        {
+            auto file = options.find("file");
+            if (file == options.end())
+            {
+                return usage();
+            }
+            std::ifstream inFile;
+            if (file->second != "-")
+            {
+                inFile.open(file->second);
+                if (inFile.is_open() == false)
+                {
+                    std::cerr << "batch: cannot read " << file->second << "\n";
+                    return 1;
+                }
+            }
+            std::ofstream outFile;
+            auto output = options.find("output");
+            if (output != options.end())
+            {
+                outFile.open(output->second);
+                if (outFile.is_open() == false)
+                {
+                    std::cerr << "batch: cannot write " << output->second << "\n";
+                    return 1;
+                }
+            }
+
+            auto engine = options.find("engine");
+            const bool useMiniMax = engine != options.end() && engine->second == "minimax";
+            if (engine != options.end() && useMiniMax == false && engine->second != "mcts")
+            {
+                std::cerr << "batch: --engine must be mcts or minimax\n";
+                return 1;
+            }
+            const int iterations = intOption(options, "mcts-iterations", 20000);
+            const int depth = intOption(options, "minimax-depth", 8);
+            BatchAnalyzer analyzer([useMiniMax, iterations, depth](int seed) {
+                return useMiniMax ? std::unique_ptr<Player>(new MiniMaxAiPlayer(depth)) : std::unique_ptr<Player>(new MctsAiPlayer(iterations, seed));
+            });
+            analyzer.setNumThreads(intOption(options, "threads", 0));
+            analyzer.setWindow(std::max(1, intOption(options, "window", 65536)));
+
+            auto start = std::chrono::steady_clock::now();
+            BatchResult result = analyzer.run(inFile.is_open() ? inFile : std::cin, outFile.is_open() ? outFile : std::cout);
+            const double seconds = secondsSince(start);
+            std::cerr << "positions: " << result.positions << ", errors: " << result.errors << ", positions/s: "
+                << result.positions / std::max(seconds, 1e-9) << "\n";
+            return 0;
+        }
+
+        /**
+         * Many simulated games against a GameService, reporting the engine's move latency. See LoadGenerator.
+         */
+        int loadtest(const Options& options)
+        {
+            auto engine = options.find("engine");
+            const bool useMiniMax = engine != options.end() && engine->second == "minimax";
+            if (engine != options.end() && useMiniMax == false && engine->second != "mcts")
+            {
+                std::cerr << "loadtest: --engine must be mcts or minimax\n";
+                return 1;
+            }
+
+            GameService service(intOption(options, "threads", 0));
+            service.setMiniMaxDepth(std::max(1, intOption(options, "minimax-depth", 8)));
+            auto bookFile = options.find("book");
+            if (bookFile != options.end())
+            {
+                std::ifstream in(bookFile->second);
+                if (in.is_open() == false)
+                {
+                    std::cerr << "loadtest: cannot read " << bookFile->second << "\n";
+                    return 1;
+                }
+                std::shared_ptr<OpeningBook> book(new OpeningBook());
+                book->load(in);
+                service.setOpeningBook(book);
+                std::cout << "book: " << book->size() << " positions\n";
+            }
+
+            LoadGenerator generator(service);
+            generator.setClients(std::max(1, intOption(options, "clients", 1000)));
+            generator.setEngine(useMiniMax ? GameService::Engine::MINIMAX : GameService::Engine::MCTS);
+            generator.setBudget(std::max(1, intOption(options, "budget", 10)));
+            generator.setThinkTime(std::max(0, intOption(options, "think", 100)));
+            generator.setDuration(static_cast<int>(doubleOption(options, "seconds", 10.0) * 1000.0));
+            generator.setSeed(intOption(options, "seed", 0));
+
+            const LoadReport report = generator.run();
+            std::cout << "threads: " << service.getNumThreads() << ", moves: " << report.moves << ", games: " << report.games
+                << ", moves/s: " << report.movesPerSecond << "\n"
+                << "latency ms: p50 " << report.p50Ms << ", p99 " << report.p99Ms << ", max " << report.maxMs
+                << ", mean queue wait " << report.meanQueueMs << "\n"
+                << "answered from book: " << report.service.bookMoves << ", cache: " << report.service.cacheMoves
+                << ", search: " << report.service.searches << "\n";
+            return 0;
+        }
+
+        /**
+         * Heap allocations of every search in MCTS vs minimax games, checked against a budget per
+         * search. Fails (exit status 1) if a search after the first warmup searches of its player goes
+         * over, for catching allocation regressions in tests. Needs a CONNECT4_ALLOC_STATS build.
+         */
+        int allocs(const Options& options)
+        {
+            if (AllocStats::enabled() == false)
+            {
+                std::cerr << "allocs: allocation accounting is not compiled in, configure with -DCONNECT4_ALLOC_STATS=ON\n";
+                return 1;
+            }
+            const int games = intOption(options, "games", 2);
+            const long long maxAllocs = static_cast<long long>(doubleOption(options, "max-allocs", -1.0)); // -1: no limit
+            const long long maxBytes = static_cast<long long>(doubleOption(options, "max-bytes", -1.0));
+            const int warmup = intOption(options, "warmup", 1);
+
+            MctsAiPlayer mcts(intOption(options, "mcts-iterations", 20000), 1);
+            MiniMaxAiPlayer miniMax(intOption(options, "minimax-depth", 8));
+            Player* players[] = { &mcts, &miniMax };
+            const char* names[] = { "mcts", "minimax" };
+            struct Totals
+            {
+                long long searches = 0;
+                AllocCounts allocs;
+                long long worstAllocs = 0; // of the searches after the warmup
+                long long worstBytes = 0;
+                long long overBudget = 0;
+            } totals[2];
+
+            for (int game = 0; game < games; game++)
+            {
+                //minimax plays through flipped markers, as the shadow player of a tournament.
+                Board board;
+                for (int turn = game % 2; board.gameEnded() == false; turn = 1 - turn)
+                {
+                    if (turn == 1)
+                    {
+                        board.flipMarkers();
+                    }
+                    players[turn]->play(board);
+                    if (turn == 1)
+                    {
+                        board.flipMarkers();
+                    }
+
+                    const AllocCounts& counts = players[turn]->getSearchStats().allocs;
+                    Totals& total = totals[turn];
+                    total.searches++;
+                    total.allocs += counts;
+                    if (total.searches <= warmup)
+                    {
+                        continue;
+                    }
+                    total.worstAllocs = std::max(total.worstAllocs, counts.totalAllocations());
+                    total.worstBytes = std::max(total.worstBytes, counts.totalBytes());
+                    if ((maxAllocs >= 0 && counts.totalAllocations() > maxAllocs) || (maxBytes >= 0 && counts.totalBytes() > maxBytes))
+                    {
+                        total.overBudget++;
+                        std::cerr << "allocs: " << names[turn] << " search " << total.searches << " of game " << game + 1 << " made "
+                            << counts.totalAllocations() << " allocations, " << counts.totalBytes() << " bytes: over budget\n";
+                    }
+                }
+            }
+
+            long long overBudget = 0;
+            for (int i = 0; i < 2; i++)
+            {
+                const Totals& total = totals[i];
+                const double searches = static_cast<double>(std::max(1ll, total.searches));
+                std::cout << names[i] << ": " << total.searches << " searches, " << total.allocs.totalAllocations() / searches << " allocations and "
+                    << total.allocs.totalBytes() / searches << " bytes per search, worst after warmup " << total.worstAllocs << " allocations, "
+                    << total.worstBytes << " bytes\n";
+                for (int c = 0; c < AllocCounts::NUM_CATEGORIES; c++)
+                {
+                    std::cout << "  " << AllocCounts::categoryName(c) << ": " << total.allocs.allocations[c] << " allocations, " << total.allocs.bytes[c] << " bytes\n";
+                }
+                overBudget += total.overBudget;
+            }
+            if (overBudget > 0)
+            {
+                std::cout << overBudget << " searches over budget\n";
+                return 1;
+            }
+            return 0;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace Connect4;
+    Options options;
+    if (argc < 2 || parseOptions(argc, argv, 2, options) == false)
+    {
+        return usage();
+    }
+
+    const std::string command = argv[1];
+    if (command == "simulate")
+    {
+        return simulate(options);
+    }
+    if (command == "bench")
+    {
+        return bench(options);
+    }
+    if (command == "analyze")
+    {
+        return analyze(options);
+    }
+    if (command == "records")
+    {
+        return records(options);
+    }
+    if (command == "perft")
+    {
+        return runPerft(options);
+    }
+    if (command == "serve")
+    {
+        return serve(options);
+    }
+    if (command == "batch")
+    {
+        return batch(options);
+    }
+    if (command == "loadtest")
+    {
+        return loadtest(options);
+    }
+    if (command == "allocs")
+    {
+        return allocs(options);
+    }
+    return usage();
+}
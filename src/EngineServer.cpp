@@ -0,0 +1,290 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include "EngineServer.h"
+#include "MctsAiPlayer.h"
+#include "MiniMaxAiPlayer.h"
+
+namespace Connect4
+{
+    EngineServer::EngineServer() : out_{ nullptr }, engine_{ Engine::MCTS }, defaultIterations_{ 20000 }, defaultDepth_{ 8 }, infoIntervalMs_{ 500 }, miniMaxDepth_{ 0 }, searching_{ nullptr }
+    {
+    }
+
+    /**
+     * MCTS iterations of a go without iterations or movetime.
+     */
+    void EngineServer::setDefaultIterations(int iterations)
+    {
+        assert(iterations > 0);
+        defaultIterations_ = iterations;
+    }
+
+    /**
+     * Minimax depth of a go without depth.
+     */
+    void EngineServer::setDefaultDepth(int depth)
+    {
+        assert(depth > 0);
+        defaultDepth_ = depth;
+    }
+
+    /**
+     * Time between info lines during a search.
+     */
+    void EngineServer::setInfoInterval(int milliseconds)
+    {
+        assert(milliseconds > 0);
+        infoIntervalMs_ = milliseconds;
+    }
+
+    int EngineServer::run(std::istream& in, std::ostream& out)
+    {
+        out_ = &out;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() == false && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            if (handle_(line) == false)
+            {
+                break;
+            }
+        }
+
+        //quit, or the other process went away: don't leave a search running.
+        {
+            std::lock_guard<std::mutex> lock(searchMutex_);
+            if (searching_)
+            {
+                searching_->stop();
+            }
+        }
+        waitForSearch_();
+        out_ = nullptr;
+        return 0;
+    }
+
+    /**
+     * Run one command. Returns false on quit.
+     */
+    bool EngineServer::handle_(const std::string& line)
+    {
+        std::istringstream args(line);
+        std::string command;
+        if (!(args >> command))
+        {
+            return true; //blank line
+        }
+
+        if (command == "isready")
+        {
+            send_("readyok");
+        }
+        else if (command == "stop")
+        {
+            std::lock_guard<std::mutex> lock(searchMutex_);
+            if (searching_)
+            {
+                searching_->stop();
+            }
+        }
+        else if (command == "quit")
+        {
+            return false;
+        }
+        else
+        {
+            //everything else changes what the search uses.
+            waitForSearch_();
+            if (command == "newgame")
+            {
+                newGame_();
+            }
+            else if (command == "position")
+            {
+                position_(args);
+            }
+            else if (command == "engine")
+            {
+                std::string name;
+                args >> name;
+                if (name == "mcts" || name == "minimax")
+                {
+                    engine_ = name == "mcts" ? Engine::MCTS : Engine::MINIMAX;
+                }
+                else
+                {
+                    send_("error unknown engine " + name);
+                }
+            }
+            else if (command == "go")
+            {
+                go_(args);
+            }
+            else
+            {
+                send_("error unknown command " + command);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * position startpos [moves 4453]
+     */
+    void EngineServer::position_(std::istringstream& args)
+    {
+        std::string token, moves;
+        args >> token;
+        if (token != "startpos")
+        {
+            send_("error position must start with startpos");
+            return;
+        }
+        if (args >> token)
+        {
+            if (token != "moves" || !(args >> moves))
+            {
+                send_("error expected moves <columns 1-7>");
+                return;
+            }
+        }
+
+        Board board;
+        if (board.playMoves(moves) == false)
+        {
+            send_("error illegal moves " + moves);
+            return;
+        }
+        board_ = board;
+    }
+
+    /**
+     * go [iterations I] [depth D] [movetime MS]
+     */
+    void EngineServer::go_(std::istringstream& args)
+    {
+        int iterations = defaultIterations_;
+        int depth = defaultDepth_;
+        int moveTimeMs = 0;
+        std::string name;
+        while (args >> name)
+        {
+            int value = 0;
+            if (!(args >> value) || value <= 0 || (name != "iterations" && name != "depth" && name != "movetime"))
+            {
+                send_("error bad go parameter " + name);
+                return;
+            }
+            (name == "iterations" ? iterations : (name == "depth" ? depth : moveTimeMs)) = value;
+        }
+
+        if (board_.gameEnded())
+        {
+            send_("bestmove none");
+            return;
+        }
+
+        if (mcts_ == nullptr)
+        {
+            newGame_();
+        }
+        Player* player = nullptr;
+        if (engine_ == Engine::MCTS)
+        {
+            mcts_->setIterations(iterations);
+            mcts_->setTimeBudget(moveTimeMs);
+            player = mcts_.get();
+        }
+        else
+        {
+            //the depth is fixed at construction. Minimax keeps nothing between moves, so nothing is lost.
+            if (miniMax_ == nullptr || miniMaxDepth_ != depth)
+            {
+                miniMax_.reset(new MiniMaxAiPlayer(depth));
+                miniMaxDepth_ = depth;
+            }
+            player = miniMax_.get();
+        }
+        player->setProgressCallback([this](const SearchStats& stats) { sendInfo_(stats); }, infoIntervalMs_);
+
+        std::lock_guard<std::mutex> lock(searchMutex_);
+        player->clearStop(); //a stop from here on is for this search.
+        searching_ = player;
+        //MCTS enforces movetime itself, minimax is stopped by a timer.
+        searchThread_ = std::thread(&EngineServer::search_, this, player, engine_ == Engine::MINIMAX ? moveTimeMs : 0);
+    }
+
+    /**
+     * Search on the worker thread, then report the final stats and the move.
+     */
+    void EngineServer::search_(Player* player, int moveTimeMs)
+    {
+        std::thread timer;
+        if (moveTimeMs > 0)
+        {
+            timer = std::thread([this, player, moveTimeMs]() {
+                std::unique_lock<std::mutex> lock(searchMutex_);
+                if (searchDone_.wait_for(lock, std::chrono::milliseconds(moveTimeMs), [this]() { return searching_ == nullptr; }) == false)
+                {
+                    player->stop();
+                }
+            });
+        }
+
+        Board board = board_;
+        player->play(board);
+        {
+            std::lock_guard<std::mutex> lock(searchMutex_);
+            searching_ = nullptr;
+        }
+        searchDone_.notify_all();
+        if (timer.joinable())
+        {
+            timer.join();
+        }
+
+        const SearchStats& stats = player->getSearchStats();
+        sendInfo_(stats);
+        send_("bestmove " + std::to_string(stats.move + 1));
+    }
+
+    void EngineServer::waitForSearch_()
+    {
+        if (searchThread_.joinable())
+        {
+            searchThread_.join();
+        }
+    }
+
+    /**
+     * Fresh players, without the trees and tables of the previous game.
+     */
+    void EngineServer::newGame_()
+    {
+        mcts_.reset(new MctsAiPlayer(defaultIterations_, 1));
+        miniMax_.reset();
+    }
+
+    void EngineServer::send_(const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        *out_ << line << std::endl;
+    }
+
+    void EngineServer::sendInfo_(const SearchStats& stats)
+    {
+        std::ostringstream line;
+        line << "info depth " << stats.maxDepth << " score " << stats.score << " nodes " << stats.nodes
+            << " nps " << static_cast<long long>(stats.nodesPerSecond) << " time " << static_cast<long long>(stats.elapsedMs);
+        send_(line.str());
+    }
+
+    EngineServer::~EngineServer()
+    {
+        waitForSearch_();
+    }
+}
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <cassert>
 #include <chrono>
+#include <future>
 #include <string>
 #include <thread>
 #include <SFML/Graphics.hpp>
@@ -11,89 +12,17 @@
 #include "MiniMaxAiPlayer.h"
 namespace Connect4
 {
-    GameController::GameController(bool isSimulation) : board_(std::make_shared<Board>()), gameView_(isSimulation ? nullptr : std::make_shared<GameView>(board_))
+    GameController::GameController() : board_(std::make_shared<Board>()), gameView_(std::make_shared<GameView>(board_))
     {
     }
 
     /**
-     * Run the game loop
+     * Run the game loop. The AI thinks on a worker thread, so the window keeps drawing and handling
+     * events meanwhile; closing the window stops the search.
+     * On the human's turn the loop sleeps in waitEvent(); otherwise it wakes up once per frame.
      */
     void GameController::run()
     {
-        // if we are running a simulation
-        if (gameView_ == nullptr)
-        {
-            board_->reset();
-
-            int numSims = 10000;
-            int numAIWins = 0;
-            int numShadowAIWins = 0;
-            int numTies = 0;
-
-            MiniMaxAiPlayer* shadowAiPlayer = new MiniMaxAiPlayer(8);
-            for (int i = 0; i < numSims; i++)
-            {
-                //Created on heap because this can cause the allocated stack to be filled up.
-                // TODO: Need code to reset random number generator engine instead of deleting objects in loop.
-                MctsAiPlayer* aiPlayer = new MctsAiPlayer(5000, i);
-
-                auto winner = Board::Markers::NONE;
-
-                //alternating first player.
-                bool fp = ((i % 2) == 0);
-
-                while (true)
-                {
-                    if (fp)
-                    {
-                        //simulated Human player.
-                        board_->flipMarkers();
-                        shadowAiPlayer->play(*board_);
-                        board_->flipMarkers();
-                    }
-                    else
-                    {
-                        aiPlayer->play(*board_);
-                    }
-                    //board_->print();
-                    winner = board_->getWinner();
-                    if (winner == Board::Markers::HUMAN_PLAYER)
-                    {
-                        numShadowAIWins++;
-                        break;
-                    }
-                    else if (winner == Board::Markers::AI_PLAYER)
-                    {
-                        numAIWins++;
-                        break;
-                    }
-                    else if (winner == Board::Markers::NONE && !board_->validMovesExist())
-                    {
-                        numTies++;
-                        break;
-                    }
-                    fp = !fp;
-                }
-
-                board_->reset();
-                delete aiPlayer;
-
-                std::cout << "Simulation # " << i << ":" << std::endl;
-                float shadowAIWinPerc = 100.0f * numShadowAIWins / (i + 1);
-                float aiWinPerc = 100.0f * numAIWins / (i + 1);
-                float tiePerc = 100.0f * numTies / (i + 1);
-
-                std::cout << "Shadow AI wins: " << shadowAIWinPerc << " %" << std::endl;
-                std::cout << "AI wins:        " << aiWinPerc << " %" << std::endl;
-                std::cout << "Ties:           " << tiePerc << " %" << std::endl;
-                std::cout << "Total:          " << shadowAIWinPerc + aiWinPerc + tiePerc << " %" << std::endl;
-                std::cout << "----------------------" << std::endl;
-            }
-            delete shadowAiPlayer;
-            return;
-        }
-
-
         //create opponent;
         //constexpr int miniMaxDepth{ 4 }; //change the depth to increase or decrease look-up depth.
         //MiniMaxAiPlayer aiPlayer(miniMaxDepth);
@@ -104,96 +33,121 @@ namespace Connect4
 
         bool humanPlayerTurn = true;
         bool gameEnded = false;
+        std::future<Board> aiMove; // the board after the AI's move, valid while the AI thinks
+        std::chrono::steady_clock::time_point closeTime;
+        const auto frameTime = std::chrono::milliseconds(1000 / GameView::FRAME_RATE_LIMIT);
+
+        const std::string msgTie = "Game ended in a tie";
+        const std::string msgAiWins = "AI Wins";
+        const std::string msgHumanWins = "You Win!";
 
+        gameView_->draw();
         while (window->isOpen())
         {
-            const std::string msgTie = "Game ended in a tie";
-            const std::string msgAiWins = "AI Wins";
-            const std::string msgHumanWins = "You Win!";
-            std::string msg;
-
-            if (humanPlayerTurn)
+            //block until the human does something, then take whatever else is queued. Not when the AI's
+            //move just ended the game: the result is announced below without waiting for an event.
+            bool waitForEvent = humanPlayerTurn && gameEnded == false && board_->gameEnded() == false;
+            sf::Event event;
+            while (waitForEvent ? window->waitEvent(event) : window->pollEvent(event))
             {
-                sf::Event event;
-                while (window->pollEvent(event))
+                waitForEvent = false;
+
+                if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus)
                 {
-                    if (event.type == sf::Event::MouseMoved)
-                    {
-                        gameView_->setPiecePosition(event.mouseMove.x);
-                    }
+                    gameView_->invalidate();
+                }
 
-                    if (event.type == sf::Event::MouseButtonPressed)
+                if (event.type == sf::Event::MouseMoved)
+                {
+                    gameView_->setPiecePosition(event.mouseMove.x);
+                }
+
+                if (event.type == sf::Event::MouseButtonPressed && humanPlayerTurn && gameEnded == false)
+                {
+                    if (event.mouseButton.button == sf::Mouse::Left)
                     {
-                        if (event.mouseButton.button == sf::Mouse::Left)
-                        {
 #ifndef NDEBUG
-                            std::cout << "the right button was pressed" << std::endl;
-                            std::cout << "mouse x: " << event.mouseButton.x << std::endl;
-                            std::cout << "mouse y: " << event.mouseButton.y << std::endl;
+                        std::cout << "the right button was pressed" << std::endl;
+                        std::cout << "mouse x: " << event.mouseButton.x << std::endl;
+                        std::cout << "mouse y: " << event.mouseButton.y << std::endl;
 #endif // !NDEBUG
-                            int col = event.mouseButton.x / gameView_->gridSize();
-                            bool validDrop = false;
-                            validDrop = board_->dropPiece(col, Board::Markers::HUMAN_PLAYER);
-                            if (validDrop == false)
-                            {
-                                continue;
-                            }
-                            humanPlayerTurn = false;
+                        int col = event.mouseButton.x / gameView_->gridSize();
+                        bool validDrop = false;
+                        validDrop = board_->dropPiece(col, Board::Markers::HUMAN_PLAYER);
+                        if (validDrop == false)
+                        {
+                            continue;
                         }
+                        humanPlayerTurn = false;
                     }
-
-                    if (event.type == sf::Event::Closed)
-                    {
-                        window->close();
-                    }
-
                 }
-            }
-            else
-            {
-                //ai Player Plays now
-                if (humanPlayerTurn == false)
+
+                if (event.type == sf::Event::Closed)
                 {
-                    aiPlayer.play(*board_);
-#ifndef NDEBUG			
-                    //move th is code to inside play with NDEBUG
-                    //miniMaxAIPlayer.playNoAlphaBeta(brdCopy);
-#endif
-                    humanPlayerTurn = true;
+                    window->close();
                 }
             }
 
-            gameView_->draw();
-
-            //Do we have a winner?
-            auto winner = board_->getWinner();
-
-            if (winner == Board::Markers::HUMAN_PLAYER)
+            if (window->isOpen() == false)
             {
-                std::cout << msgHumanWins << std::endl;
-                gameEnded = true;
-                msg = msgHumanWins;
+                break;
             }
-            else if (winner == Board::Markers::AI_PLAYER)
+
+            //Do we have a winner? Checked before the AI's turn, a human move may have ended the game.
+            if (gameEnded == false && board_->gameEnded())
             {
-                std::cout << msgAiWins << std::endl;
+                auto winner = board_->getWinner();
+                std::string msg = winner == Board::Markers::HUMAN_PLAYER ? msgHumanWins :
+                    (winner == Board::Markers::AI_PLAYER ? msgAiWins : msgTie);
+                std::cout << msg << std::endl;
                 gameEnded = true;
-                msg = msgAiWins;
+                aiPlayer.stopPondering();
+
+                //leave the final position up for a while, still handling events.
+                closeTime = std::chrono::steady_clock::now() + std::chrono::seconds(10);
             }
-            else if (winner == Board::Markers::NONE && !board_->validMovesExist())
+
+            //ai Player Plays now, on a copy of the board so the view never sees a half made move.
+            if (humanPlayerTurn == false && gameEnded == false)
             {
-                std::cout << msgTie << std::endl;
-                gameEnded = true;
-                msg = msgTie;
+                if (aiMove.valid() == false)
+                {
+                    aiPlayer.clearStop();
+                    aiMove = std::async(std::launch::async, [&aiPlayer](Board board) {
+                        aiPlayer.play(board);
+                        return board;
+                    }, *board_);
+                }
+                else if (aiMove.wait_for(frameTime) == std::future_status::ready)
+                {
+                    *board_ = aiMove.get();
+                    humanPlayerTurn = true;
+
+                    //think on the human's time.
+                    if (board_->gameEnded() == false)
+                    {
+                        aiPlayer.startPondering(*board_);
+                    }
+                }
             }
 
+            gameView_->draw();
+
             if (gameEnded)
             {
-                using std::chrono::operator""s;
-                std::this_thread::sleep_until(std::chrono::system_clock::now() + 10s);
-                std::cout << msg << std::endl;
-                window->close();
+                if (std::chrono::steady_clock::now() >= closeTime)
+                {
+                    window->close();
+                }
+                std::this_thread::sleep_for(frameTime);
             }
         }
+
+        //the window was closed while the AI was thinking.
+        if (aiMove.valid())
+        {
+            aiPlayer.stop();
+            aiMove.wait();
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,300 @@
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cassert>
+#include <cstring>
+#include "GameRecord.h"
+
+namespace Connect4
+{
+    static const char MAGIC[4] = { 'C', '4', 'G', 'R' };
+    static constexpr uint16_t VERSION = 2;
+    static constexpr size_t FILE_HEADER_SIZE = 8;
+
+    GameRecordWriter::GameRecordWriter(const std::string& path, size_t bufferSize) : file_{ nullptr }, bufferSize_{ bufferSize }
+    {
+        if (openForAppend_(path) == false)
+        {
+            if (file_)
+            {
+                std::fclose(file_);
+            }
+            file_ = nullptr;
+            return;
+        }
+        buffer_.reserve(bufferSize_);
+    }
+
+    /**
+     * Open the file and position it after its last complete record, writing the file header first
+     * if the file is new (or shorter than the header). False if the file can't be opened or isn't
+     * a game record file of this version.
+     */
+    bool GameRecordWriter::openForAppend_(const std::string& path)
+    {
+        file_ = std::fopen(path.c_str(), "r+b");
+        if (file_ == nullptr)
+        {
+            file_ = std::fopen(path.c_str(), "w+b");
+            if (file_ == nullptr)
+            {
+                return false;
+            }
+        }
+
+        std::fseek(file_, 0, SEEK_END);
+        const long fileSize = std::ftell(file_);
+        long end = 0;
+        if (fileSize >= static_cast<long>(FILE_HEADER_SIZE))
+        {
+            char header[FILE_HEADER_SIZE];
+            uint16_t version = 0;
+            std::fseek(file_, 0, SEEK_SET);
+            if (std::fread(header, 1, sizeof(header), file_) != sizeof(header))
+            {
+                return false;
+            }
+            std::memcpy(&version, header + 4, sizeof(version));
+            if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+            {
+                return false;
+            }
+
+            //walk the record headers to the end of the last complete record.
+            end = FILE_HEADER_SIZE;
+            GameRecordHeader record;
+            while (std::fseek(file_, end, SEEK_SET) == 0 && std::fread(&record, sizeof(record), 1, file_) == 1 &&
+                end + static_cast<long>(gameRecordSize(record.numMoves)) <= fileSize)
+            {
+                end += static_cast<long>(gameRecordSize(record.numMoves));
+            }
+        }
+
+        if (end < fileSize)
+        {
+            std::fflush(file_);
+#ifdef _WIN32
+            if (_chsize_s(_fileno(file_), end) != 0)
+#else
+            if (ftruncate(fileno(file_), end) != 0)
+#endif
+            {
+                return false;
+            }
+        }
+        std::fseek(file_, end, SEEK_SET);
+        if (end == 0)
+        {
+            char header[FILE_HEADER_SIZE] = {};
+            std::memcpy(header, MAGIC, sizeof(MAGIC));
+            std::memcpy(header + 4, &VERSION, sizeof(VERSION));
+            std::fwrite(header, 1, sizeof(header), file_);
+        }
+        return true;
+    }
+
+    bool GameRecordWriter::isOpen() const
+    {
+        return file_ != nullptr;
+    }
+
+    void GameRecordWriter::write(const GameRecord& record)
+    {
+        assert(record.moves.size() == record.header.numMoves && record.moveTimesUs.size() == record.header.numMoves);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_ == nullptr)
+        {
+            return;
+        }
+
+        const size_t numMoves = record.moves.size();
+        const size_t size = gameRecordSize(numMoves);
+        if (buffer_.size() + size > bufferSize_)
+        {
+            flushLocked_();
+        }
+
+        const size_t offset = buffer_.size();
+        buffer_.resize(offset + size); //the padding is zero filled.
+        char* out = buffer_.data() + offset;
+        std::memcpy(out, &record.header, sizeof(GameRecordHeader));
+        out += sizeof(GameRecordHeader);
+        std::memcpy(out, record.moves.data(), numMoves);
+        out += (numMoves + 3) & ~size_t{ 3 };
+        std::memcpy(out, record.moveTimesUs.data(), numMoves * sizeof(uint32_t));
+    }
+
+    void GameRecordWriter::flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushLocked_();
+    }
+
+    void GameRecordWriter::flushLocked_()
+    {
+        if (file_ && buffer_.empty() == false)
+        {
+            std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+            std::fflush(file_);
+        }
+        buffer_.clear();
+    }
+
+    GameRecordWriter::~GameRecordWriter()
+    {
+        flush();
+        if (file_)
+        {
+            std::fclose(file_);
+        }
+    }
+
+    /**
+     * Map the whole file read only. The reader stays empty if the file is missing or isn't a game
+     * record file.
+     */
+    GameRecordReader::GameRecordReader(const std::string& path) : data_{ nullptr }, size_{ 0 }
+    {
+#ifdef _WIN32
+        fileHandle_ = INVALID_HANDLE_VALUE;
+        mappingHandle_ = nullptr;
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        fileHandle_ = file;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart < static_cast<LONGLONG>(FILE_HEADER_SIZE))
+        {
+            return;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            return;
+        }
+        mappingHandle_ = mapping;
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr)
+        {
+            return;
+        }
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(FILE_HEADER_SIZE))
+        {
+            void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED)
+            {
+                data_ = static_cast<const char*>(view);
+                size_ = static_cast<size_t>(st.st_size);
+                //games are read front to back.
+                madvise(view, size_, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd); //the mapping stays valid.
+#endif
+
+        uint16_t version = 0;
+        if (data_)
+        {
+            std::memcpy(&version, data_ + 4, sizeof(version));
+            if (std::memcmp(data_, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+            {
+                unmap_();
+            }
+        }
+    }
+
+    void GameRecordReader::unmap_()
+    {
+        if (data_)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(data_);
+#else
+            munmap(const_cast<char*>(data_), size_);
+#endif
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    bool GameRecordReader::isOpen() const
+    {
+        return data_ != nullptr;
+    }
+
+    GameRecordReader::Iterator GameRecordReader::begin() const
+    {
+        return isOpen() ? Iterator(data_, size_, FILE_HEADER_SIZE) : end();
+    }
+
+    GameRecordReader::Iterator GameRecordReader::end() const
+    {
+        return Iterator(data_, size_, size_);
+    }
+
+    GameRecordReader::~GameRecordReader()
+    {
+        unmap_();
+#ifdef _WIN32
+        if (mappingHandle_)
+        {
+            CloseHandle(mappingHandle_);
+        }
+        if (fileHandle_ != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(fileHandle_);
+        }
+#endif
+    }
+
+    GameRecordReader::Iterator::Iterator(const char* data, size_t size, size_t offset) : data_{ data }, size_{ size }, offset_{ offset }, recordSize_{ 0 }, view_{}
+    {
+        load_();
+    }
+
+    GameRecordReader::Iterator& GameRecordReader::Iterator::operator++()
+    {
+        offset_ += recordSize_;
+        load_();
+        return *this;
+    }
+
+    /**
+     * Point the view at the record at offset_, or move to the end if there is no complete record.
+     */
+    void GameRecordReader::Iterator::load_()
+    {
+        if (offset_ + sizeof(GameRecordHeader) > size_)
+        {
+            offset_ = size_;
+            return;
+        }
+        const auto* header = reinterpret_cast<const GameRecordHeader*>(data_ + offset_);
+        recordSize_ = gameRecordSize(header->numMoves);
+        if (offset_ + recordSize_ > size_ || header->numMoves > header->numRows * header->numCols)
+        {
+            offset_ = size_;
+            return;
+        }
+        view_.header = header;
+        view_.moves = reinterpret_cast<const uint8_t*>(header + 1);
+        view_.moveTimesUs = reinterpret_cast<const uint32_t*>(view_.moves + ((header->numMoves + 3) & ~size_t{ 3 }));
+    }
+}
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cassert>
+#include "BitBoard.h"
+#include "Board.h"
+#include "GameService.h"
+#include "MctsAiPlayer.h"
+#include "MiniMaxAiPlayer.h"
+
+namespace Connect4
+{
+    GameService::GameService(int numThreads, size_t cacheEntries) : miniMaxDepth_{ 8 }, cache_{ cacheEntries }, nextSession_{ 1 }, stopping_{ false },
+        moves_{ 0 }, bookMoves_{ 0 }, cacheMoves_{ 0 }
+    {
+        numThreads_ = numThreads > 0 ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        searching_.assign(numThreads_, nullptr);
+        for (int i = 0; i < numThreads_; i++)
+        {
+            workers_.emplace_back(&GameService::worker_, this, i);
+        }
+    }
+
+    void GameService::setMiniMaxDepth(int depth)
+    {
+        assert(depth > 0);
+        miniMaxDepth_ = depth;
+    }
+
+    /**
+     * Answer from book (nullptr: no book) before looking in the cache.
+     */
+    void GameService::setOpeningBook(std::shared_ptr<const OpeningBook> book)
+    {
+        book_ = book;
+    }
+
+    GameService::SessionId GameService::createSession(Engine engine)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const SessionId session = nextSession_++;
+        sessions_[session] = { std::string(), engine, false, false };
+        return session;
+    }
+
+    /**
+     * A request of the session still being served is answered, but its move is not applied.
+     */
+    bool GameService::closeSession(SessionId session)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.erase(session) > 0;
+    }
+
+    bool GameService::playMove(SessionId session, int column)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(session);
+        if (it == sessions_.end() || it->second.waiting || it->second.ended || column < 0 || column >= 7)
+        {
+            return false;
+        }
+        Board board;
+        const std::string moves = it->second.moves + static_cast<char>('1' + column);
+        if (board.playMoves(moves) == false)
+        {
+            return false;
+        }
+        it->second.moves = moves;
+        it->second.ended = board.gameEnded();
+        return true;
+    }
+
+    bool GameService::requestMove(SessionId session, int budgetMs, MoveCallback done)
+    {
+        assert(budgetMs > 0);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(session);
+            if (it == sessions_.end() || it->second.waiting || it->second.ended)
+            {
+                return false;
+            }
+            it->second.waiting = true;
+            queue_.push_back({ session, it->second.moves, it->second.engine, budgetMs, done, std::chrono::steady_clock::now() });
+        }
+        workAvailable_.notify_one();
+        return true;
+    }
+
+    std::string GameService::getMoves(SessionId session) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(session);
+        return it == sessions_.end() ? std::string() : it->second.moves;
+    }
+
+    ServiceStats GameService::getStats() const
+    {
+        ServiceStats stats;
+        stats.moves = moves_.load(std::memory_order_relaxed);
+        stats.bookMoves = bookMoves_.load(std::memory_order_relaxed);
+        stats.cacheMoves = cacheMoves_.load(std::memory_order_relaxed);
+        stats.searches = stats.moves - stats.bookMoves - stats.cacheMoves;
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.sessions = static_cast<long long>(sessions_.size());
+        stats.queued = static_cast<long long>(queue_.size());
+        return stats;
+    }
+
+    int GameService::getNumThreads() const
+    {
+        return numThreads_;
+    }
+
+    void GameService::worker_(int workerIndex)
+    {
+        //players are made on first use, so a service that only plays one engine only has those.
+        std::unique_ptr<MctsAiPlayer> mcts;
+        std::unique_ptr<MiniMaxAiPlayer> miniMax;
+        for (;;)
+        {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                workAvailable_.wait(lock, [this]() { return stopping_ || queue_.empty() == false; });
+                if (stopping_)
+                {
+                    return;
+                }
+                request = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            MoveResult result;
+            result.queueMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request.submitted).count();
+            Board board;
+            board.playMoves(request.moves);
+            const uint64_t key = BitBoard(board).key();
+            const int engine = static_cast<int>(request.engine);
+
+            if (book_ && book_->lookup(board, result.column, result.score))
+            {
+                result.source = MoveResult::Source::BOOK;
+                board.dropPiece(result.column, Board::Markers::AI_PLAYER);
+                bookMoves_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (cache_.probe(key, engine, request.budgetMs, result.column, result.score))
+            {
+                result.source = MoveResult::Source::CACHE;
+                board.dropPiece(result.column, Board::Markers::AI_PLAYER);
+                cacheMoves_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                Player* player = nullptr;
+                if (request.engine == Engine::MCTS)
+                {
+                    if (mcts == nullptr)
+                    {
+                        mcts.reset(new MctsAiPlayer(1, workerIndex + 1)); //the time budget replaces the iteration count
+                    }
+                    mcts->setTimeBudget(request.budgetMs);
+                    player = mcts.get();
+                }
+                else
+                {
+                    if (miniMax == nullptr)
+                    {
+                        miniMax.reset(new MiniMaxAiPlayer(miniMaxDepth_));
+                    }
+                    miniMax->setTimeBudget(request.budgetMs);
+                    player = miniMax.get();
+                }
+                if (search_(workerIndex, *player, board) == false)
+                {
+                    return;
+                }
+                const SearchStats& stats = player->getSearchStats();
+                result.column = stats.move;
+                result.score = stats.score;
+
+                //a minimax search cut by the budget stopped at a depth that depends on the load, don't serve it again.
+                if (request.engine == Engine::MCTS || stats.depth >= miniMaxDepth_)
+                {
+                    cache_.store(key, engine, request.budgetMs, result.column, result.score);
+                }
+            }
+            result.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request.submitted).count();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = sessions_.find(request.session);
+                result.applied = it != sessions_.end();
+                if (result.applied)
+                {
+                    it->second.moves += static_cast<char>('1' + result.column);
+                    it->second.ended = board.gameEnded();
+                    it->second.waiting = false;
+                }
+            }
+            moves_.fetch_add(1, std::memory_order_relaxed);
+            if (request.done)
+            {
+                request.done(request.session, result);
+            }
+        }
+    }
+
+    /**
+     * player.play(board), where the destructor can stop it. False if the service is shutting down.
+     */
+    bool GameService::search_(int workerIndex, Player& player, Board& board)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+            {
+                return false;
+            }
+            player.clearStop();
+            searching_[workerIndex] = &player;
+        }
+        player.play(board);
+        std::lock_guard<std::mutex> lock(mutex_);
+        searching_[workerIndex] = nullptr;
+        return stopping_ == false;
+    }
+
+    GameService::~GameService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            queue_.clear();
+            for (Player* player : searching_)
+            {
+                if (player)
+                {
+                    player->stop();
+                }
+            }
+        }
+        workAvailable_.notify_all();
+        for (std::thread& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#include <cmath>
 #include "GameView.h"
 #include "Board.h"
 
@@ -28,9 +29,80 @@ namespace Connect4
         gameWindowHeight_ = static_cast<unsigned int>(gridSize_ * nRowsWindow);
 
         dropPieceX_ = 0;
+        dirty_ = true;
 
         window_ = new sf::RenderWindow(sf::VideoMode(gameWindowWidth_, gameWindowHeight_), "Connect 4");
+        window_->setFramerateLimit(FRAME_RATE_LIMIT);
 
+        buildGeometry_();
+    }
+
+    /**
+     * Build the background, the grid lines and one triangle fan per cell. Each cell is CIRCLE_SEGMENTS
+     * triangles in a single vertex array, so the whole board is one draw call.
+     */
+    void GameView::buildGeometry_()
+    {
+        background_.setSize(sf::Vector2f(static_cast<float>(nCols_ * gridSize_), static_cast<float>(nRows_ * gridSize_)));
+        background_.setFillColor(sf::Color::Blue);
+        background_.setPosition(0, static_cast<float>(gridSize_));
+
+        pieceToDrop_.setRadius(gridSize_ / 2.0f);
+        pieceToDrop_.setFillColor(sf::Color::Yellow);
+
+        const float pi = 3.14159265f;
+        const float radius = gridSize_ / 2.0f;
+        cells_.setPrimitiveType(sf::Triangles);
+        cells_.resize(nRows_ * nCols_ * CIRCLE_SEGMENTS * 3);
+        size_t v = 0;
+        for (size_t c = 0; c < nCols_; c++)
+        {
+            for (size_t r = 0; r < nRows_; r++)
+            {
+                sf::Vector2f center(c * gridSize_ + radius, (nRows_ - r) * gridSize_ + radius);
+                for (int i = 0; i < CIRCLE_SEGMENTS; i++)
+                {
+                    const float a0 = 2 * pi * i / CIRCLE_SEGMENTS;
+                    const float a1 = 2 * pi * (i + 1) / CIRCLE_SEGMENTS;
+                    cells_[v++].position = center;
+                    cells_[v++].position = center + sf::Vector2f(radius * std::cos(a0), radius * std::sin(a0));
+                    cells_[v++].position = center + sf::Vector2f(radius * std::cos(a1), radius * std::sin(a1));
+                }
+            }
+        }
+
+        gridLines_.setPrimitiveType(sf::Lines);
+        for (size_t i = 1; i < nCols_; i++)
+        {
+            gridLines_.append(sf::Vertex(sf::Vector2f(static_cast<float>(i * gridSize_), static_cast<float>(gridSize_))));
+            gridLines_.append(sf::Vertex(sf::Vector2f(static_cast<float>(i * gridSize_), static_cast<float>(gameWindowHeight_)))); //second is y (height)
+        }
+        for (size_t i = 1; i <= nRows_; i++)
+        {
+            gridLines_.append(sf::Vertex(sf::Vector2f(0, static_cast<float>(i * gridSize_))));
+            gridLines_.append(sf::Vertex(sf::Vector2f(static_cast<float>(gameWindowWidth_), static_cast<float>(i * gridSize_)))); //second is y (height)
+        }
+    }
+
+    /**
+     * Color the cells after the board.
+     */
+    void GameView::updateCells_()
+    {
+        const auto& gameBoard = board_->getBoard();
+        size_t v = 0;
+        for (size_t c = 0; c < nCols_; c++)
+        {
+            for (size_t r = 0; r < nRows_; r++)
+            {
+                auto color = (gameBoard[r][c] == Board::Markers::NONE) ? sf::Color::Black : (gameBoard[r][c] == Board::Markers::AI_PLAYER) ? sf::Color::Red : sf::Color::Yellow;
+                for (int i = 0; i < CIRCLE_SEGMENTS * 3; i++)
+                {
+                    cells_[v++].color = color;
+                }
+            }
+        }
+        shownMoves_ = board_->getMoves();
     }
 
     /**
@@ -48,64 +120,46 @@ namespace Connect4
      */
     void GameView::setPiecePosition(int mouseX)
     {
-        dropPieceX_ = mouseX;
+        if (mouseX != dropPieceX_)
+        {
+            dropPieceX_ = mouseX;
+            dirty_ = true;
+        }
     }
 
     /**
-     * Display the board.
+     * Force the next draw() to redraw, e.g. after the window was resized or regained focus.
      */
-    void GameView::draw()
+    void GameView::invalidate()
     {
-        window_->clear();
-        sf::RectangleShape blueBackground;
-        blueBackground.setSize(sf::Vector2f(nCols_ * gridSize_, nRows_ * gridSize_));
-        blueBackground.setFillColor(sf::Color::Blue);
-        blueBackground.setPosition(0, gridSize_);
-
-        window_->draw(blueBackground);
-
-        sf::CircleShape pieceToDrop(gridSize_ / 2);
-        pieceToDrop.setFillColor(sf::Color::Yellow);
-        pieceToDrop.setPosition(dropPieceX_ - gridSize_ / 2, 0);
-
-        window_->draw(pieceToDrop);
+        dirty_ = true;
+    }
 
-        for (int c = 0; c < nCols_; c++)
+    /**
+     * Display the board. Nothing is drawn unless the board or the piece to drop changed since the
+     * last frame; a board change is seen through the column heights, every move changes one.
+     */
+    void GameView::draw()
+    {
+        if (board_->getMoves() != shownMoves_)
         {
-            for (int r = 0; r < nRows_; r++)
-            {
-                sf::CircleShape gridCircle(gridSize_ / 2);
-                gridCircle.setPosition(c * gridSize_, (nRows_ - r) * gridSize_);
-
-                auto gameBoard = board_->getBoard();
-                auto color = (gameBoard[r][c] == Board::Markers::NONE) ? sf::Color::Black : (gameBoard[r][c] == Board::Markers::AI_PLAYER) ? sf::Color::Red : sf::Color::Yellow;
-                gridCircle.setFillColor(color);
-
-                window_->draw(gridCircle);
-            }
+            updateCells_();
+            dirty_ = true;
         }
-        for (int i = 1; i < nCols_; i++)
+        if (dirty_ == false)
         {
-            sf::Vertex line[] =
-            {
-                sf::Vertex(sf::Vector2f(i * gridSize_, gridSize_)),
-                sf::Vertex(sf::Vector2f(i * gridSize_, gameWindowHeight_)) //second is y (height)
-            };
-
-            window_->draw(line, 2, sf::Lines);
+            return;
         }
-        for (int i = 1; i <= nRows_; i++)
-        {
-            sf::Vertex line[] =
-            {
-                sf::Vertex(sf::Vector2f(0, i * gridSize_)),
-                sf::Vertex(sf::Vector2f(gameWindowWidth_, i * gridSize_)) //second is y (height)
-            };
 
-            window_->draw(line, 2, sf::Lines);
-        }
+        pieceToDrop_.setPosition(dropPieceX_ - gridSize_ / 2.0f, 0);
 
+        window_->clear();
+        window_->draw(background_);
+        window_->draw(pieceToDrop_);
+        window_->draw(cells_);
+        window_->draw(gridLines_);
         window_->display();
+        dirty_ = false;
     }
 
     /**
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include "Board.h"
+#include "LoadGenerator.h"
+
+namespace Connect4
+{
+    LoadGenerator::LoadGenerator(GameService& service) : service_(service), numClients_{ 1000 }, engine_{ GameService::Engine::MCTS }, budgetMs_{ 10 },
+        thinkMs_{ 100 }, durationMs_{ 10000 }, seed_{ 0 }, games_{ 0 }, inFlight_{ 0 }, queueMs_{ 0.0 } {}
+
+    void LoadGenerator::setClients(int numClients)
+    {
+        assert(numClients > 0);
+        numClients_ = numClients;
+    }
+
+    void LoadGenerator::setEngine(GameService::Engine engine)
+    {
+        engine_ = engine;
+    }
+
+    void LoadGenerator::setBudget(int milliseconds)
+    {
+        assert(milliseconds > 0);
+        budgetMs_ = milliseconds;
+    }
+
+    void LoadGenerator::setThinkTime(int milliseconds)
+    {
+        assert(milliseconds >= 0);
+        thinkMs_ = milliseconds;
+    }
+
+    void LoadGenerator::setDuration(int milliseconds)
+    {
+        assert(milliseconds >= 0);
+        durationMs_ = milliseconds;
+    }
+
+    /**
+     * Client i plays with seed + i.
+     */
+    void LoadGenerator::setSeed(int seed)
+    {
+        seed_ = seed;
+    }
+
+    LoadReport LoadGenerator::run()
+    {
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point end = start + std::chrono::milliseconds(durationMs_);
+        games_ = 0;
+        latencies_.clear();
+        queueMs_ = 0.0;
+        clients_.clear();
+        for (int i = 0; i < numClients_; i++)
+        {
+            clients_.push_back({ service_.createSession(engine_), FastRandom(static_cast<uint64_t>(seed_ + i)), i % 2 == 0 });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (int i = 0; i < numClients_; i++)
+        {
+            //spread the first moves over a think time, as if the clients had connected one by one.
+            due_.push({ thinkUntil_(clients_[i]), i });
+        }
+        while (Clock::now() < end)
+        {
+            if (due_.empty() == false && due_.top().first <= Clock::now())
+            {
+                const int clientIndex = due_.top().second;
+                due_.pop();
+                lock.unlock();
+                step_(clientIndex);
+                lock.lock();
+            }
+            else
+            {
+                wake_.wait_until(lock, due_.empty() ? end : std::min(end, due_.top().first));
+            }
+        }
+        wake_.wait(lock, [this]() { return inFlight_ == 0; });
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        due_ = decltype(due_)();
+        lock.unlock();
+
+        for (const Client& client : clients_)
+        {
+            service_.closeSession(client.session);
+        }
+
+        LoadReport report;
+        report.moves = static_cast<long long>(latencies_.size());
+        report.games = games_;
+        report.seconds = seconds;
+        report.movesPerSecond = seconds > 0.0 ? report.moves / seconds : 0.0;
+        if (latencies_.empty() == false)
+        {
+            std::sort(latencies_.begin(), latencies_.end());
+            auto percentile = [this](double p) { return latencies_[std::min(latencies_.size() - 1, static_cast<size_t>(p * latencies_.size()))]; };
+            report.p50Ms = percentile(0.5);
+            report.p99Ms = percentile(0.99);
+            report.maxMs = latencies_.back();
+            report.meanQueueMs = queueMs_ / latencies_.size();
+        }
+        report.service = service_.getStats();
+        return report;
+    }
+
+    /**
+     * Play the client's moves until it is the engine's turn, then ask the engine. A game that ends
+     * on the way is replaced by a new one.
+     */
+    void LoadGenerator::step_(int clientIndex)
+    {
+        Client& client = clients_[clientIndex];
+        for (;;)
+        {
+            const std::string moves = service_.getMoves(client.session);
+            Board board;
+            board.playMoves(moves);
+            if (board.gameEnded())
+            {
+                service_.closeSession(client.session);
+                client.session = service_.createSession(engine_);
+                client.engineFirst = !client.engineFirst;
+                games_++;
+                continue;
+            }
+
+            if (((moves.size() % 2) == 0) == client.engineFirst)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    inFlight_++;
+                }
+                const bool queued = service_.requestMove(client.session, budgetMs_,
+                    [this, clientIndex](GameService::SessionId, const MoveResult& result) { answered_(clientIndex, result); });
+                assert(queued);
+                (void)queued;
+                return;
+            }
+
+            std::vector<int> legal;
+            const std::vector<int>& rowInColumn = board.getMoves();
+            for (int col = 0; col < static_cast<int>(rowInColumn.size()); col++)
+            {
+                if (rowInColumn[col] < static_cast<int>(board.getNumRows()))
+                {
+                    legal.push_back(col);
+                }
+            }
+            service_.playMove(client.session, legal[client.random.bounded(static_cast<uint32_t>(legal.size()))]);
+        }
+    }
+
+    /**
+     * On a service worker: record the latency and schedule the client's reply.
+     */
+    void LoadGenerator::answered_(int clientIndex, const MoveResult& result)
+    {
+        //notify under the lock: once inFlight_ is 0, run() may return and take wake_ with it.
+        std::lock_guard<std::mutex> lock(mutex_);
+        latencies_.push_back(result.totalMs);
+        queueMs_ += result.queueMs;
+        due_.push({ thinkUntil_(clients_[clientIndex]), clientIndex });
+        inFlight_--;
+        wake_.notify_one();
+    }
+
+    LoadGenerator::Clock::time_point LoadGenerator::thinkUntil_(Client& client) const
+    {
+        return Clock::now() + std::chrono::microseconds(thinkMs_ == 0 ? 0 : client.random.bounded(2000u * thinkMs_));
+    }
+}
@@ -1,29 +1,579 @@
 #include "MctsAiPlayer.h"
 #include <cmath>
 #include <cassert>
+#include <limits>
+#include <chrono>
+#include <algorithm>
 
 namespace Connect4
 {
-    MctsAiPlayer::MctsAiPlayer(int iterations, int randSeed) : iterations_{ iterations }, mtRand_{ randSeed }{}
+    // Number of iterations between two clock reads in the time-budgeted search.
+    static constexpr int TIME_CHECK_INTERVAL = 64;
 
-    void MctsAiPlayer::play(Board& board)
+    // Without a node budget, pondering stops after creating this many nodes, so a long think of the
+    // opponent doesn't use up all memory.
+    static constexpr size_t MAX_PONDER_NODES = 1 << 21;
+
+    // Fraction of the nodes (by visit count) whose subtrees are cut when the node budget is reached.
+    static constexpr double PRUNE_FRACTION = 0.5;
+
+    template <typename BoardT>
+    BasicMctsAiPlayer<BoardT>::BasicMctsAiPlayer(int iterations, int randSeed) : iterations_{ iterations }, rolloutsPerLeaf_{ 1 }, timeBudgetMs_{ 0 }, maxNodes_{ 0 }, useSolver_{ true }, useTranspositions_{ false }, useRave_{ false }, raveEquivalence_{ 300 }, leafEvaluation_{ LeafEvaluation::ROLLOUT }, leafPlies_{ 16 }, nodeBudget_{ 0 }, markEpoch_{ 0 }, nodesCreated_{ 0 }, searchStats_{ nullptr }, searchFirstNode_{ 0 }, root_{ nullptr }, stopPondering_{ false }, stopSearch_{ false }, rolloutEngine_{ static_cast<uint64_t>(randSeed) }
+    {
+        stats_.engine = "mcts";
+    }
+
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::play(Board& board)
+    {
+        stopPondering();
+        stats_.reset();
+        if (board.gameEnded())
+        {
+            //no move to make, and a terminal root has no child to pick.
+            return;
+        }
+        startAllocCount_();
+        startProgress_();
+        searchStart_ = std::chrono::steady_clock::now();
+        searchFirstNode_ = nodesCreated_;
+        searchStats_ = &stats_;
+
+        Node* root = findRoot_(BoardT(board));
+        Node* bChild = nullptr;
+        if (timeBudgetMs_ > 0)
+        {
+            searchTimed_(root);
+            bChild = mostVisitedChild_(root);
+        }
+        else
+        {
+            //a solved root has nothing left to search. Even when stopped, one iteration gives the root a child.
+            for (int iter = 0; iter < iterations_ && root->getProof() == Node::Proof::UNKNOWN && (iter == 0 || stopSearch_ == false); iter++)
+            {
+                search_(root, true);
+            }
+            bChild = bestChild(root, 0);
+        }
+        searchStats_ = nullptr;
+
+        const int column = root->getBoard().columnOf(root->getMoveTo(bChild));
+        stats_.move = column;
+        stats_.score = bChild->getMeanReward();
+        stats_.nodes = static_cast<long long>(nodesCreated_ - searchFirstNode_);
+        for (const Node* child : root->getChildren())
+        {
+            stats_.rootChildren.push_back({ root->getBoard().columnOf(root->getMoveTo(child)), child->getVisits(), child->getMeanReward(), false });
+        }
+        stats_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart_).count();
+        stats_.nodesPerSecond = stats_.elapsedMs > 0.0 ? stats_.nodes * 1000.0 / stats_.elapsedMs : 0.0;
+        stopAllocCount_();
+        publishStats_();
+        board.dropPiece(column, Board::Markers::AI_PLAYER);
+
+        //keep the subtree of the move played, the opponent's reply will be one of its children.
+        root_ = bChild;
+    }
+
+    /**
+     * Keep searching the position after our move while the opponent thinks. Only the tree is
+     * touched, so play() can pick up the subtree of the opponent's actual move.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::startPondering(const Board& board)
+    {
+        stopPondering();
+        root_ = findRoot_(BoardT(board));
+        ponderThread_ = std::thread(&BasicMctsAiPlayer::ponder_, this);
+    }
+
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::stopPondering()
     {
-        Node root(board);
-        for (int iter = 0; iter < iterations_; iter++)
+        if (ponderThread_.joinable())
         {
-            bool isAiTurn = true;
-            Node* nd = treePolicy_(&root, isAiTurn);
-            int reward = defaultPolicy(nd, isAiTurn);
-            backup_(nd, reward, isAiTurn); //no need to pass paramenters... just pass reward based on whether its aiturn
+            stopPondering_ = true;
+            ponderThread_.join();
         }
+        stopPondering_ = false;
+    }
 
-        Node* bChild = bestChild(&root, 0);
-        board = bChild->getBoard();
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::stop()
+    {
+        stopSearch_ = true;
     }
 
-    MctsAiPlayer::~MctsAiPlayer()
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::clearStop()
     {
-        for (int i = 0; i < nodes_.size(); ++i)
+        stopSearch_ = false;
+    }
+
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::ponder_()
+    {
+        const size_t firstNode = nodesCreated_;
+        while (stopPondering_ == false && root_->getProof() == Node::Proof::UNKNOWN &&
+            (nodeBudget_ > 0 || nodesCreated_ - firstNode < MAX_PONDER_NODES))
+        {
+            search_(root_, false); //the opponent is to move at the root.
+        }
+    }
+
+    /**
+     * Root node for board. Reuses the previous root or one of its children (the tree of the last
+     * move or of pondering) if it has the same position, otherwise starts a new tree.
+     * Everything that is no longer reachable from the root is recycled.
+     */
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::findRoot_(const BoardT& board)
+    {
+        const Mask key = board.key();
+        Node* root = nullptr;
+        if (root_)
+        {
+            if (root_->getBoard().key() == key)
+            {
+                root = root_;
+            }
+            for (Node* child : root_->getChildren())
+            {
+                if (child->getBoard().key() == key)
+                {
+                    root = child;
+                }
+            }
+        }
+
+        if (root == nullptr)
+        {
+            //unrelated position, such as a new game. The table may hold the same position with the
+            //other player to move, so it can't be reused either.
+            table_.clear();
+            root = newNode_(board);
+        }
+        root_ = root;
+        collectGarbage_(root_);
+        return root_;
+    }
+
+    /**
+     * Allocate a node, reusing a free one when possible. New nodes are live in the current epoch.
+     */
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::newNode_(const BoardT& board)
+    {
+        CONNECT4_ALLOC_SCOPE(AllocCategory::TREE);
+        Node* node = nullptr;
+        if (freeNodes_.empty() == false)
+        {
+            node = freeNodes_.back();
+            freeNodes_.pop_back();
+            node->reset(board);
+        }
+        else
+        {
+            node = new Node(board);
+            nodes_.push_back(node);
+        }
+        node->setMark(markEpoch_);
+        nodesCreated_++;
+        return node;
+    }
+
+    template <typename BoardT>
+    size_t BasicMctsAiPlayer<BoardT>::liveNodes_() const
+    {
+        return nodes_.size() - freeNodes_.size();
+    }
+
+    /**
+     * Mark and sweep: nodes not reachable from root go back to the free list, and the transposition
+     * table is rebuilt from the live nodes.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::collectGarbage_(Node* root)
+    {
+        CONNECT4_ALLOC_SCOPE(AllocCategory::TREE);
+        markEpoch_++;
+        stack_.clear();
+        root->setMark(markEpoch_);
+        stack_.push_back(root);
+        while (stack_.empty() == false)
+        {
+            Node* v = stack_.back();
+            stack_.pop_back();
+            for (Node* child : v->getChildren())
+            {
+                if (child->getMark() != markEpoch_)
+                {
+                    child->setMark(markEpoch_);
+                    stack_.push_back(child);
+                }
+            }
+        }
+
+        freeNodes_.clear();
+        table_.clear();
+        for (Node* node : nodes_)
+        {
+            if (node->getMark() != markEpoch_)
+            {
+                freeNodes_.push_back(node);
+            }
+            else if (useTranspositions_)
+            {
+                table_[node->getBoard().key()] = node;
+            }
+        }
+    }
+
+    /**
+     * Called when the node budget is reached: cut the edges to the least visited nodes (the lowest
+     * PRUNE_FRACTION of the live nodes by visits) and recycle whatever becomes unreachable. A cut
+     * move goes back to the parent's untried moves, so it can be expanded again later. The root's
+     * children are kept, the move choice needs them, and so are the children of proven nodes, the
+     * proof rests on them.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::prune_(Node* root)
+    {
+        CONNECT4_ALLOC_SCOPE(AllocCategory::TREE);
+        visitScratch_.clear();
+        for (const Node* node : nodes_)
+        {
+            if (node->getMark() == markEpoch_ && node != root)
+            {
+                visitScratch_.push_back(node->getVisits());
+            }
+        }
+        if (visitScratch_.empty())
+        {
+            return;
+        }
+        auto nth = visitScratch_.begin() + static_cast<size_t>(PRUNE_FRACTION * (visitScratch_.size() - 1));
+        std::nth_element(visitScratch_.begin(), nth, visitScratch_.end());
+        const int threshold = *nth;
+
+        for (Node* node : nodes_)
+        {
+            if (node->getMark() != markEpoch_ || node == root || node->getProof() != Node::Proof::UNKNOWN)
+            {
+                continue;
+            }
+            const auto& children = node->getChildren();
+            for (size_t i = children.size(); i-- > 0;)
+            {
+                if (children[i]->getVisits() <= threshold)
+                {
+                    node->removeChild(i);
+                }
+            }
+        }
+        collectGarbage_(root);
+    }
+
+    /**
+     * One MCTS iteration: selection/expansion, simulation and backpropagation.
+     * isAiTurn is the player to move at the root.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::search_(Node* root, bool isAiTurn)
+    {
+        //prune between iterations, never while a path is being walked.
+        if (nodeBudget_ > 0 && liveNodes_() >= nodeBudget_)
+        {
+            prune_(root);
+        }
+        Node* nd = treePolicy_(root, isAiTurn);
+        if (searchStats_)
+        {
+            searchStats_->iterations++;
+            searchStats_->maxDepth = std::max(searchStats_->maxDepth, static_cast<int>(path_.size()) - 1);
+            if (nd->isTerminal())
+            {
+                searchStats_->leaves++;
+            }
+            else
+            {
+                searchStats_->rollouts += rolloutsPerLeaf_;
+            }
+        }
+        double reward = defaultPolicy(nd, isAiTurn);
+        backup_(reward, rolloutsPerLeaf_, isAiTurn); //no need to pass paramenters... just pass reward based on whether its aiturn
+
+        if (searchStats_ && searchStats_->iterations % TIME_CHECK_INTERVAL == 0 && progressDue_())
+        {
+            reportProgress_(root);
+        }
+    }
+
+    /**
+     * Hand the stats so far to the progress callback, with the most visited root child as the move.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::reportProgress_(const Node* root)
+    {
+        const Node* best = mostVisitedChild_(root);
+        if (best == nullptr)
+        {
+            return;
+        }
+        stats_.move = root->getBoard().columnOf(root->getMoveTo(best));
+        stats_.score = best->getMeanReward();
+        stats_.nodes = static_cast<long long>(nodesCreated_ - searchFirstNode_);
+        stats_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart_).count();
+        stats_.nodesPerSecond = stats_.elapsedMs > 0.0 ? stats_.nodes * 1000.0 / stats_.elapsedMs : 0.0;
+        progress_(stats_);
+    }
+
+    /**
+     * Anytime search: run iterations until the time budget is spent, the node budget is hit or stop() is called.
+     * Stops earlier when the most visited root child can no longer be overtaken, assuming the
+     * remaining time is spent at the iteration rate measured so far.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::searchTimed_(Node* root)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const auto deadline = start + std::chrono::milliseconds(timeBudgetMs_);
+        const size_t firstNode = nodesCreated_;
+
+        for (long long iter = 1; root->getProof() == Node::Proof::UNKNOWN; iter++)
+        {
+            search_(root, true);
+            if (stopSearch_ || (maxNodes_ > 0 && nodesCreated_ - firstNode >= static_cast<size_t>(maxNodes_)))
+            {
+                break;
+            }
+            if (iter % TIME_CHECK_INTERVAL != 0)
+            {
+                continue;
+            }
+
+            const auto now = Clock::now();
+            if (now >= deadline)
+            {
+                break;
+            }
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            double remaining = std::chrono::duration<double>(deadline - now).count();
+            double remainingVisits = iter * rolloutsPerLeaf_ * remaining / elapsed;
+            if (canStopEarly_(root, remainingVisits))
+            {
+                break;
+            }
+        }
+    }
+
+    /**
+     * True if spending remainingVisits more visits cannot change the most visited root child.
+     */
+    template <typename BoardT>
+    bool BasicMctsAiPlayer<BoardT>::canStopEarly_(const Node* root, double remainingVisits) const
+    {
+        if (root->isFullyExpanded() == false)
+        {
+            return false;
+        }
+        const auto& children = root->getChildren();
+        if (children.size() == 1)
+        {
+            return true; //only one legal move.
+        }
+
+        int mostVisits = 0;
+        int secondVisits = 0;
+        for (const Node* child : children)
+        {
+            int visits = child->getVisits();
+            if (visits > mostVisits)
+            {
+                secondVisits = mostVisits;
+                mostVisits = visits;
+            }
+            else if (visits > secondVisits)
+            {
+                secondVisits = visits;
+            }
+        }
+        return (mostVisits - secondVisits) > remainingVisits;
+    }
+
+    /**
+     * The robust child: the most visited one. Used as the final move choice of the anytime search,
+     * whose early termination is based on visit counts.
+     */
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::mostVisitedChild_(const Node* v) const
+    {
+        Node* winChild = provenWinChild_(v);
+        if (winChild)
+        {
+            return winChild;
+        }
+
+        //proven losses only if there is nothing else.
+        Node* best = nullptr;
+        for (Node* child : v->getChildren())
+        {
+            bool isLoss = child->getProof() == Node::Proof::LOSS;
+            bool bestIsLoss = best && best->getProof() == Node::Proof::LOSS;
+            if (best == nullptr || (bestIsLoss && !isLoss) ||
+                (bestIsLoss == isLoss && child->getVisits() > best->getVisits()))
+            {
+                best = child;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * A child that is a proven win for the player to move at v, or nullptr.
+     */
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::provenWinChild_(const Node* v) const
+    {
+        for (Node* child : v->getChildren())
+        {
+            if (child->getProof() == Node::Proof::WIN)
+            {
+                return child;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Number of playouts run from every expanded leaf (batch mode). The summed reward is backed up
+     * once, counting as rolloutsPerLeaf visits. Defaults to 1.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setRolloutsPerLeaf(int rolloutsPerLeaf)
+    {
+        assert(rolloutsPerLeaf > 0);
+        rolloutsPerLeaf_ = rolloutsPerLeaf;
+    }
+
+    /**
+     * Number of iterations per move when there is no time budget.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setIterations(int iterations)
+    {
+        assert(iterations > 0);
+        iterations_ = iterations;
+    }
+
+    /**
+     * Switch to the anytime search: each move searches for the given number of milliseconds,
+     * or until maxNodes new nodes have been created (0 means no node limit), instead of a fixed
+     * number of iterations. A budget of 0 milliseconds goes back to the fixed iteration count.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setTimeBudget(int milliseconds, int maxNodes)
+    {
+        assert(milliseconds >= 0 && maxNodes >= 0);
+        timeBudgetMs_ = milliseconds;
+        maxNodes_ = maxNodes;
+    }
+
+    /**
+     * MCTS-Solver (on by default): terminal positions are proven wins or draws and proofs are
+     * propagated up the tree during backup. Proven children are then chosen or avoided without
+     * spending more rollouts on them, and the search stops as soon as the root is solved.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setSolver(bool useSolver)
+    {
+        useSolver_ = useSolver;
+    }
+
+    /**
+     * Merge transpositions (off by default): positions reached through different move orders share
+     * one node, found through a table keyed by BitBoard::key(), which turns the tree into a DAG.
+     * Node statistics are shared by all parents, while the exploration term of the selection uses
+     * the visits of the parent-child edge (UCT3, Childs et al. 2008), so that a child already well
+     * explored through another parent is still tried from this one.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setTranspositions(bool useTranspositions)
+    {
+        useTranspositions_ = useTranspositions;
+    }
+
+    /**
+     * Move selection in the playouts. RolloutPolicy::TACTICAL costs more per move but plays
+     * immediate wins and blocks, which makes the rollout results much less noisy.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setRolloutPolicy(RolloutPolicy policy)
+    {
+        rolloutEngine_.setPolicy(policy);
+    }
+
+    /**
+     * Lane count of the vector playout kernel used in batch mode (see setRolloutsPerLeaf), or 0
+     * to turn it off.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setSimdLanes(int lanes)
+    {
+        rolloutEngine_.setSimdLanes(lanes);
+    }
+
+    /**
+     * RAVE (Gelly and Silver 2007): every playout also updates the all-moves-as-first statistics of
+     * the siblings whose move was played later in the same playout (in the tree or in the rollout)
+     * by the same player. Selection blends the AMAF mean into the UCB1 exploitation term with
+     * weight beta = sqrt(k / (3n + k)), where n is the child's visits and k the equivalence
+     * parameter. AMAF dominates for new nodes and fades out as real visits accumulate.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setRave(bool useRave, int equivalence)
+    {
+        assert(equivalence > 0);
+        useRave_ = useRave;
+        raveEquivalence_ = equivalence;
+    }
+
+    /**
+     * How a new leaf is valued. LeafEvaluation::ROLLOUT (the default) plays to the end of the game.
+     * TRUNCATED stops the playouts after plies moves and scores the position reached with the
+     * minimax heuristic, mapped to [-1, 1] (RolloutEngine::heuristicValue). ALPHA_BETA replaces the
+     * playouts with an alpha-beta search plies deep over the same heuristic. Both hybrids trade the
+     * noise of long random playouts for the bias of the heuristic: the truncated playouts are
+     * cheaper than full ones, and the alpha-beta value sees short tactics a playout misses. With
+     * the window heuristic, plies of about 16 for TRUNCATED and 1 or 2 for ALPHA_BETA are the
+     * sensible range. Batched playouts (setSimdLanes) only serve ROLLOUT.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setLeafEvaluation(LeafEvaluation leafEvaluation, int plies)
+    {
+        assert(plies >= 0);
+        leafEvaluation_ = leafEvaluation;
+        leafPlies_ = plies;
+    }
+
+    /**
+     * Cap the number of live nodes (0, the default, means no cap). When the cap is reached, the
+     * least visited subtrees are pruned and their nodes reused, so long games, pondering and large
+     * iteration counts run in a fixed amount of memory. Independently of the budget, the part of
+     * the tree that the game has moved away from is recycled on every move.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::setNodeBudget(size_t maxNodes)
+    {
+        nodeBudget_ = maxNodes;
+    }
+
+    template <typename BoardT>
+    BasicMctsAiPlayer<BoardT>::~BasicMctsAiPlayer()
+    {
+        stopPondering();
+        for (size_t i = 0; i < nodes_.size(); ++i)
         {
             delete nodes_[i];
         }
@@ -37,8 +587,11 @@ namespace Connect4
     *               v <- BESTCHILD(v, Cp)
     *       return v
     */
-    Node* MctsAiPlayer::treePolicy_(Node* v, bool& isAiTurn)
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::treePolicy_(Node* v, bool& isAiTurn)
     {
+        path_.clear();
+        path_.push_back(v);
         while (v->isTerminal() == false)
         {
             //if not fully expanded
@@ -53,58 +606,50 @@ namespace Connect4
             {
                 isAiTurn = !isAiTurn;
                 v = bestChild(v, 2.0); //explore factor of 2.0 change this to something else!!!!!
+                path_.push_back(v);
             }
         }
         return v;
     }
 
-    Node* MctsAiPlayer::expand_(Node* v, bool& isAiTurn)
+    /**
+     * Add a child for the next untried move. The untried moves are kept as a bitmask in the
+     * node, so there is no scanning of the board or of the moves tried so far.
+     */
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::expand_(Node* v, bool& isAiTurn)
     {
-        auto board = v->getBoard(); //make a copy.
-        const auto& rowInColumn = board.getMoves();
-        //assert here. v should not be 7 or more.
+        CONNECT4_ALLOC_SCOPE(AllocCategory::TREE);
+        assert(v->getUntriedMoves() != 0);
+        Mask move = v->popUntriedMove();
 
-        static int nRows = board.getNumRows(); //in play , initialize nRows and nCols.
-        static int nCols = board.getNumCols();
+        BoardT board = v->getBoard();
+        board.play(move, isAiTurn);
 
-        //create a method for getting valid moves, because this is repeated code.
-        auto& moves = board.getMoves();
-        std::vector<int> validMoves;
-        for (int i = 0; i < moves.size(); i++)
+        Node* childNode = nullptr;
+        if (useTranspositions_)
         {
-            if (moves[i] < nRows)
+            Node*& entry = table_[board.key()];
+            if (entry == nullptr)
             {
-                validMoves.push_back(i);
+                entry = newNode_(board);
             }
+            childNode = entry;
         }
-
-        auto& triedMoves = v->getTriedMoves();
-        int nextMove = -1;
-        for (int move : validMoves)
+        else
         {
-            if (std::find(triedMoves.begin(), triedMoves.end(), move) == triedMoves.end())
-            {
-                nextMove = move;
-                break;
-            }
+            childNode = newNode_(board);
         }
-
-        assert(nextMove != -1);
-
-        board.dropPiece(nextMove, isAiTurn ? Board::Markers::AI_PLAYER : Board::Markers::HUMAN_PLAYER);
-        v->addMove(nextMove);
-
-        Node* childNode = new Node(board);
-        nodes_.push_back(childNode);
         v->addChild(childNode);
-
+        path_.push_back(childNode);
 
         isAiTurn = !isAiTurn;
 
         return childNode;
     }
 
-    Node* MctsAiPlayer::bestChild(const Node* v, float exploreFactor)
+    template <typename BoardT>
+    typename BasicMctsAiPlayer<BoardT>::Node* BasicMctsAiPlayer<BoardT>::bestChild(const Node* v, float exploreFactor)
     {
         const auto& children = v->getChildren();
         Node* bestChild = nullptr;
@@ -116,13 +661,34 @@ namespace Connect4
         //With visits = 664 and reward = -47, the values are 0.23950075347874555 and 0.239500761
         //Notice that the values with float calculations are the same.
 
-        for (Node* child : children)
+        //exploit = reward / visits and explore = sqrt(2 ln(parent visits) / visits). The per-child
+        //terms are cached in the child on backup, and the parent term is computed once per call.
+        double exploreScale = exploreFactor * std::sqrt(2.0 * std::log(v->getVisits()));
+
+        if (useSolver_)
         {
-            int visits = child->getVisits();
-            int reward = child->getReward();
-            double exploit = (reward * 1.0 / visits); //we start with visits = 1, so we wont have to worry about divide by zero error.
-            double explore = std::sqrt(2.0 * (std::log(v->getVisits())) / visits);
-            double ucb1Value = exploit + exploreFactor * explore;
+            Node* winChild = provenWinChild_(v);
+            if (winChild)
+            {
+                return winChild;
+            }
+        }
+
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            Node* child = children[i];
+            if (useSolver_ && child->getProof() == Node::Proof::LOSS)
+            {
+                continue;
+            }
+            double invSqrtVisits = useTranspositions_ ? 1.0 / std::sqrt(v->getEdgeVisits(i)) : child->getInvSqrtVisits();
+            double exploit = child->getMeanReward();
+            if (useRave_ && child->getAmafVisits() > 0)
+            {
+                double beta = std::sqrt(raveEquivalence_ / (3.0 * child->getVisits() + raveEquivalence_));
+                exploit = (1.0 - beta) * exploit + beta * child->getAmafMeanReward();
+            }
+            double ucb1Value = exploit + exploreScale * invSqrtVisits;
 
             if (ucb1Value > bestUcb1Value)
             {
@@ -130,143 +696,357 @@ namespace Connect4
                 bestChild = child;
             }
         }
+
+        if (bestChild == nullptr)
+        {
+            //every move is a proven loss. This only happens at the root, pick the most resilient one.
+            bestChild = mostVisitedChild_(v);
+        }
         return bestChild;
     }
 
-    int MctsAiPlayer::defaultPolicy(const Node* v, bool isAiTurn)
+    /**
+     * Value of the node's position by the leaf evaluation. Returns the summed reward (AI perspective)
+     * of rolloutsPerLeaf_ playouts; an alpha-beta value is searched once and counts for all of them.
+     */
+    template <typename BoardT>
+    double BasicMctsAiPlayer<BoardT>::defaultPolicy(const Node* v, bool isAiTurn)
     {
-        int numRows = v->getBoard().getNumRows();
-        int numCols = v->getBoard().getNumCols();
-        Board brd = v->getBoard(); //make a copy. We are going to modify this.
-        while (brd.gameEnded() == false) //check if state(board) is non-terminal.
+        CONNECT4_ALLOC_SCOPE(AllocCategory::ROLLOUT);
+        if (leafEvaluation_ == LeafEvaluation::ALPHA_BETA)
         {
-            auto& moves = brd.getMoves();
-            std::vector<int> validMoves;
-            for (int i = 0; i < moves.size(); i++)
+            double value = rolloutEngine_.alphaBeta(v->getBoard(), isAiTurn, leafPlies_);
+            if (useRave_)
             {
-                if (moves[i] < numRows)
-                {
-                    validMoves.push_back(i);
-                }
+                backupAmaf_(v->getBoard(), value, isAiTurn);
             }
-            //uniform_int_distribution is a lightweight object and doesn't introduce a bottleneck. This
-            //was benchmarked against a custom random generator that doesnt require changing range everytime it is called.
-            int upperBound = validMoves.size() - 1;
-            int randTurnIndex = std::uniform_int_distribution<int>{ 0, upperBound }(mtRand_); // range [0, upperBound]
-            int col = validMoves[randTurnIndex];
-
-            brd.dropPiece(col, isAiTurn ? Board::Markers::AI_PLAYER : Board::Markers::HUMAN_PLAYER);
-            isAiTurn = !isAiTurn;
+            return value * rolloutsPerLeaf_;
         }
-        auto winner = brd.getWinner();
-        if (winner == Board::Markers::AI_PLAYER)
+        if (useRave_ == false && leafEvaluation_ == LeafEvaluation::ROLLOUT)
         {
-            return 1;
+            return rolloutEngine_.rollouts(v->getBoard(), isAiTurn, rolloutsPerLeaf_);
         }
-        else if (winner == Board::Markers::HUMAN_PLAYER)
-        {
-            return -1;
-        }
-        else
+
+        //truncated playouts, and RAVE, which needs the moves of every playout, go one at a time.
+        double reward = 0.0;
+        BoardT finalBoard;
+        for (int i = 0; i < rolloutsPerLeaf_; i++)
         {
-            return 0;
+            double r = leafEvaluation_ == LeafEvaluation::TRUNCATED ? rolloutEngine_.truncatedRollout(v->getBoard(), isAiTurn, leafPlies_, &finalBoard) :
+                rolloutEngine_.rollout(v->getBoard(), isAiTurn, &finalBoard);
+            if (useRave_)
+            {
+                backupAmaf_(finalBoard, r, isAiTurn);
+            }
+            reward += r;
         }
-        return 0;
+        return reward;
     }
 
-    void MctsAiPlayer::backup_(Node* v, int reward, bool isAiTurn)
+    /**
+     * Back up the reward along the path of the current iteration. The path is used instead of parent
+     * links because a node has several parents when transpositions are merged.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::backup_(double reward, int numRollouts, bool isAiTurn)
     {
         reward = isAiTurn ? -reward : reward;
-        while (v)
+        for (size_t i = path_.size(); i-- > 0;)
         {
-            v->updateVisits();
-            v->updateReward(reward);
-            v = v->getParent();
+            Node* v = path_[i];
+            v->update(reward, numRollouts);
+            if (i > 0)
+            {
+                Node* parent = path_[i - 1];
+                if (useTranspositions_)
+                {
+                    parent->updateEdge(v, numRollouts);
+                }
+                //the parent's value can only change if the child below it is proven.
+                if (useSolver_ && v->getProof() != Node::Proof::UNKNOWN)
+                {
+                    updateProof_(parent);
+                }
+            }
             reward = -reward;
         }
     }
 
-    const Board& Node::getBoard() const
+    /**
+     * Update the AMAF statistics along the path for one playout that ended on finalBoard.
+     * reward is from the AI's point of view and isAiTurn is the player to move at the leaf.
+     */
+    template <typename BoardT>
+    void BasicMctsAiPlayer<BoardT>::backupAmaf_(const BoardT& finalBoard, double reward, bool isAiTurn)
+    {
+        for (size_t i = path_.size(); i-- > 0;)
+        {
+            const Node* v = path_[i];
+            //cells the player to move at v played from v on, in the tree and in the playout.
+            Mask played = isAiTurn ? (finalBoard.getAiMask() & ~v->getBoard().getAiMask()) :
+                (finalBoard.getHumanMask() & ~v->getBoard().getHumanMask());
+            double childReward = isAiTurn ? reward : -reward; //children's statistics are from the mover's side.
+            for (Node* child : v->getChildren())
+            {
+                if (played & v->getMoveTo(child))
+                {
+                    child->updateAmaf(childReward);
+                }
+            }
+            isAiTurn = !isAiTurn;
+        }
+    }
+
+    /**
+     * Solver rule, from the point of view of the player to move at v: v is lost for the player who
+     * moved into it as soon as one child is a proven win, and won if every child is a proven loss.
+     * If every child is proven and none is a win, but some are draws, v is a draw.
+     * Returns true if v is proven.
+     */
+    template <typename BoardT>
+    bool BasicMctsAiPlayer<BoardT>::updateProof_(Node* v)
+    {
+        if (v->getProof() != Node::Proof::UNKNOWN)
+        {
+            return true;
+        }
+
+        bool allProven = v->isFullyExpanded();
+        bool anyDraw = false;
+        for (const Node* child : v->getChildren())
+        {
+            auto proof = child->getProof();
+            if (proof == Node::Proof::WIN)
+            {
+                v->setProof(Node::Proof::LOSS);
+                return true;
+            }
+            allProven = allProven && (proof != Node::Proof::UNKNOWN);
+            anyDraw = anyDraw || (proof == Node::Proof::DRAW);
+        }
+
+        if (allProven)
+        {
+            v->setProof(anyDraw ? Node::Proof::DRAW : Node::Proof::WIN);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename BoardT>
+    const BoardT& MctsNode<BoardT>::getBoard() const
     {
         return board_;
     }
 
-    const std::vector<Node*>& Node::getChildren() const
+    template <typename BoardT>
+    const std::vector<MctsNode<BoardT>*>& MctsNode<BoardT>::getChildren() const
     {
         return children_;
     }
 
-    const std::vector<int>& Node::getTriedMoves() const
+    /**
+     * The cell played to go from this node to one of its children.
+     */
+    template <typename BoardT>
+    typename BoardT::Mask MctsNode<BoardT>::getMoveTo(const Node* child) const
+    {
+        return board_.getMask() ^ child->getBoard().getMask();
+    }
+
+    template <typename BoardT>
+    typename BoardT::Mask MctsNode<BoardT>::getUntriedMoves() const
     {
-        return triedMoves_;
+        return untriedMoves_;
     }
 
-    void Node::addMove(int move)
+    /**
+     * Remove and return the lowest untried move (leftmost column first).
+     */
+    template <typename BoardT>
+    typename BoardT::Mask MctsNode<BoardT>::popUntriedMove()
     {
-        triedMoves_.push_back(move);
+        Mask move = untriedMoves_ & (~untriedMoves_ + 1);
+        untriedMoves_ ^= move;
+        return move;
     }
 
-    void Node::addChild(Node* child)
+    template <typename BoardT>
+    void MctsNode<BoardT>::addChild(Node* child)
     {
         children_.push_back(child);
-        child->setParent_(this);
+        edgeVisits_.push_back(1);
+    }
+
+    /**
+     * Cut the edge to a child and put its move back among the untried moves.
+     */
+    template <typename BoardT>
+    void MctsNode<BoardT>::removeChild(size_t childIndex)
+    {
+        untriedMoves_ |= getMoveTo(children_[childIndex]);
+        children_[childIndex] = children_.back();
+        children_.pop_back();
+        edgeVisits_[childIndex] = edgeVisits_.back();
+        edgeVisits_.pop_back();
     }
 
-    int Node::getVisits() const
+    template <typename BoardT>
+    int MctsNode<BoardT>::getVisits() const
     {
         return visits_;
     }
 
-    bool Node::isFullyExpanded() const
+    template <typename BoardT>
+    int MctsNode<BoardT>::getEdgeVisits(size_t childIndex) const
+    {
+        return edgeVisits_[childIndex];
+    }
+
+    template <typename BoardT>
+    void MctsNode<BoardT>::updateEdge(const Node* child, int count)
     {
-        auto& moves = board_.getMoves();
-        auto numRows = board_.getNumRows();
-        int numValidMoves = 0;
-        for (int i = 0; i < moves.size(); i++)
+        for (size_t i = 0; i < children_.size(); i++)
         {
-            if (moves[i] < numRows)
+            if (children_[i] == child)
             {
-                numValidMoves++;
+                edgeVisits_[i] += count;
+                return;
             }
         }
-        return (numValidMoves == children_.size());
+        assert(false);
     }
 
-    int Node::getReward() const
+    template <typename BoardT>
+    bool MctsNode<BoardT>::isFullyExpanded() const
+    {
+        return untriedMoves_ == 0;
+    }
+
+    template <typename BoardT>
+    double MctsNode<BoardT>::getReward() const
     {
         return reward_;
     }
 
-    void Node::updateVisits()
+    template <typename BoardT>
+    double MctsNode<BoardT>::getMeanReward() const
     {
-        visits_++;
+        return meanReward_;
     }
 
-    void Node::updateReward(int reward)
+    template <typename BoardT>
+    double MctsNode<BoardT>::getInvSqrtVisits() const
     {
+        return invSqrtVisits_;
+    }
+
+    /**
+     * Add count visits with a summed reward, and refresh the cached UCB terms.
+     */
+    template <typename BoardT>
+    void MctsNode<BoardT>::update(double reward, int count)
+    {
+        visits_ += count;
         reward_ += reward;
+        meanReward_ = reward_ / visits_;
+        invSqrtVisits_ = 1.0 / std::sqrt(visits_);
+    }
+
+    template <typename BoardT>
+    int MctsNode<BoardT>::getAmafVisits() const
+    {
+        return amafVisits_;
     }
 
-    Node* Node::getParent() const
+    template <typename BoardT>
+    double MctsNode<BoardT>::getAmafMeanReward() const
     {
-        return parent_;
+        return amafReward_ / amafVisits_;
     }
 
-    void Node::setParent_(Node* parent)
+    template <typename BoardT>
+    void MctsNode<BoardT>::updateAmaf(double reward)
     {
-        parent_ = parent;
+        amafVisits_++;
+        amafReward_ += reward;
     }
 
-    Node::Node(Board& board)
+    template <typename BoardT>
+    typename MctsNode<BoardT>::Proof MctsNode<BoardT>::getProof() const
+    {
+        return proof_;
+    }
+
+    template <typename BoardT>
+    void MctsNode<BoardT>::setProof(Proof proof)
+    {
+        proof_ = proof;
+    }
+
+    template <typename BoardT>
+    unsigned int MctsNode<BoardT>::getMark() const
+    {
+        return mark_;
+    }
+
+    template <typename BoardT>
+    void MctsNode<BoardT>::setMark(unsigned int mark)
+    {
+        mark_ = mark;
+    }
+
+    template <typename BoardT>
+    MctsNode<BoardT>::MctsNode(const BoardT& board)
+    {
+        reset(board);
+    }
+
+    /**
+     * (Re)initialize the node for a position. The child vectors keep their capacity, so a recycled
+     * node doesn't allocate.
+     */
+    template <typename BoardT>
+    void MctsNode<BoardT>::reset(const BoardT& board)
     {
         board_ = board;
-        parent_ = nullptr;
+        children_.clear();
+        edgeVisits_.clear();
+        mark_ = 0;
         visits_ = 1; // 0 in the algorithm, but this doesn't affect gameplay when number of simulations is sufficiently large.
-        reward_ = 0;
+        reward_ = 0.0;
+        amafVisits_ = 0;
+        amafReward_ = 0.0;
+        meanReward_ = 0.0;
+        invSqrtVisits_ = 1.0;
+        isTerminal_ = board_.gameEnded();
+        untriedMoves_ = isTerminal_ ? Mask(0) : board_.possibleMoves();
+
+        //only the player who moved into a terminal node can have won.
+        proof_ = Proof::UNKNOWN;
+        if (isTerminal_)
+        {
+            proof_ = (board_.getWinner() == Board::Markers::NONE) ? Proof::DRAW : Proof::WIN;
+        }
+    }
+
+    template <typename BoardT>
+    bool MctsNode<BoardT>::isTerminal() const
+    {
+        return isTerminal_;
     }
 
-    bool Node::isTerminal() const
+    std::unique_ptr<Player> makeMctsPlayer(size_t nRows, size_t nCols, int iterations, int randSeed)
     {
-        return board_.gameEnded();
+        if (BitBoard::fits(nRows, nCols))
+        {
+            return std::unique_ptr<Player>(new MctsAiPlayer(iterations, randSeed));
+        }
+        return std::unique_ptr<Player>(new WideMctsAiPlayer(iterations, randSeed));
     }
-}
\ No newline at end of file
+
+    template class MctsNode<BitBoard>;
+    template class MctsNode<WideBitBoard>;
+    template class BasicMctsAiPlayer<BitBoard>;
+    template class BasicMctsAiPlayer<WideBitBoard>;
+}
@@ -1,6 +1,7 @@
 #include "MiniMaxAiPlayer.h"
 #include "Board.h"
 #include "Globals.h"
+#include "BitBoard.h"
 #include <cassert>
 #include <climits>
 #include <iostream>
@@ -9,9 +10,17 @@
 
 namespace Connect4
 {
-    MiniMaxAiPlayer::MiniMaxAiPlayer(int depth) : depth_{ depth }, WINNING_SCORE{ 1000 }
+    //positions searched between two looks at the clock, when there is a time budget.
+    static constexpr long long TIME_CHECK_INTERVAL = 1024;
+
+    MiniMaxAiPlayer::MiniMaxAiPlayer(int depth) : depth_{ depth }, WINNING_SCORE{ 1000 }, rootDepth_{ depth }, rootFirst_{ -1 }, stopSearch_{ false }, stopPondering_{ false }, searchStats_{ nullptr }, timeBudgetMs_{ 0 }, timeUp_{ false }
     {
+        stats_.engine = "minimax";
+    }
 
+    MiniMaxAiPlayer::~MiniMaxAiPlayer()
+    {
+        stopPondering();
     }
 
     /**
@@ -19,21 +28,159 @@ namespace Connect4
      */
     void MiniMaxAiPlayer::play(Board& board)
     {
+        stopPondering();
+        stats_.reset();
+        startAllocCount_();
+        startProgress_();
         int bestMove = -1;
-#ifndef NDEBUG
-        auto t1 = std::chrono::high_resolution_clock::now();
-#endif
-        miniMax_(board, bestMove, depth_, INT_MIN, INT_MAX, true);
-#ifndef NDEBUG
-        auto t2 = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
-        std::cout << std::endl;
-        std::cout << "Minimax computation time: " << duration << " microseconds ~ " << duration / 1000000 << " seconds" << std::endl;
-        std::cout << "AI drops piece on column " << bestMove << "." << std::endl;
-#endif
+        searchStart_ = std::chrono::steady_clock::now();
+        deadline_ = searchStart_ + std::chrono::milliseconds(timeBudgetMs_);
+        timeUp_ = false;
+        auto pondered = ponderMoves_.empty() ? ponderMoves_.end() : ponderMoves_.find(BitBoard(board).key());
+        if (pondered != ponderMoves_.end())
+        {
+            //the search is deterministic, this is what iterativeDeepening_ would return.
+            const PonderedMove& reply = pondered->second;
+            bestMove = reply.move;
+            stats_.score = reply.score;
+            stats_.depth = reply.depth;
+            stats_.maxDepth = reply.depth;
+            stats_.rootChildren.push_back({ reply.move, 0, static_cast<double>(reply.score), false });
+        }
+        else
+        {
+            searchStats_ = &stats_;
+            int bestScore = 0;
+            iterativeDeepening_(board, bestMove, bestScore);
+            stats_.score = bestScore;
+            searchStats_ = nullptr;
+        }
+        ponderMoves_.clear();
+
+        //stopped before the first depth was done: any legal move will do.
+        const std::vector<int>& rowInColumn = board.getMoves();
+        for (int col = 0; bestMove < 0 && col < static_cast<int>(rowInColumn.size()); col++)
+        {
+            if (rowInColumn[col] < static_cast<int>(board.getNumRows()))
+            {
+                bestMove = col;
+            }
+        }
+
+        stats_.move = bestMove;
+        stats_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart_).count();
+        stats_.nodesPerSecond = stats_.elapsedMs > 0.0 ? stats_.nodes * 1000.0 / stats_.elapsedMs : 0.0;
+        stopAllocCount_();
+        publishStats_();
         board.dropPiece(bestMove, Board::Markers::AI_PLAYER);
     }
 
+    /**
+     * Hand the stats so far to the progress callback, after a root move has been searched.
+     */
+    void MiniMaxAiPlayer::reportProgress_(int bestMove, int bestValue)
+    {
+        stats_.move = bestMove;
+        stats_.score = bestValue;
+        stats_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart_).count();
+        stats_.nodesPerSecond = stats_.elapsedMs > 0.0 ? stats_.nodes * 1000.0 / stats_.elapsedMs : 0.0;
+        progress_(stats_);
+    }
+
+    /**
+     * While the opponent thinks, search our reply to each of its moves (center columns first, they
+     * are the likeliest) and keep the best moves for play(). The moves are keyed by BitBoard::key(),
+     * so boards that don't fit in a BitBoard are not pondered.
+     */
+    void MiniMaxAiPlayer::startPondering(const Board& board)
+    {
+        stopPondering();
+        ponderMoves_.clear();
+        if (BitBoard::fits(board.getNumRows(), board.getNumCols()) == false)
+        {
+            return;
+        }
+        ponderThread_ = std::thread(&MiniMaxAiPlayer::ponder_, this, board);
+    }
+
+    void MiniMaxAiPlayer::stopPondering()
+    {
+        if (ponderThread_.joinable())
+        {
+            stopPondering_ = true;
+            ponderThread_.join();
+            stopPondering_ = false;
+        }
+    }
+
+    void MiniMaxAiPlayer::stop()
+    {
+        stopSearch_ = true;
+    }
+
+    void MiniMaxAiPlayer::clearStop()
+    {
+        stopSearch_ = false;
+    }
+
+    /**
+     * play() is stopped by stop() and the time budget, ponder_() (searchStats_ is null) only by stopPondering().
+     */
+    bool MiniMaxAiPlayer::stopped_() const
+    {
+        if (searchStats_ == nullptr)
+        {
+            return stopPondering_.load(std::memory_order_relaxed);
+        }
+        return timeUp_ || stopSearch_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Stop play() after milliseconds (0: no limit), as stop() would, even if depth_ isn't reached.
+     * The move is then the best one of the last depth completed.
+     */
+    void MiniMaxAiPlayer::setTimeBudget(int milliseconds)
+    {
+        assert(milliseconds >= 0);
+        timeBudgetMs_ = milliseconds;
+    }
+
+    /**
+     * Heuristic score of a position, from the AI player's point of view.
+     */
+    int MiniMaxAiPlayer::evaluate(const Board& board) const
+    {
+        return computeScore_(board);
+    }
+
+    void MiniMaxAiPlayer::ponder_(Board board)
+    {
+        int nCols = static_cast<int>(board.getNumCols());
+        for (int i = 0; i < nCols; i++)
+        {
+            //center out: 3, 2, 4, 1, 5, 0, 6 on a 7 column board.
+            int col = (nCols - 1) / 2 + ((i % 2) ? -(i + 1) / 2 : i / 2);
+            if (board.getMoves()[col] >= static_cast<int>(board.getNumRows()))
+            {
+                continue;
+            }
+            Board reply = board;
+            reply.dropPiece(col, Board::Markers::HUMAN_PLAYER);
+            if (reply.gameEnded())
+            {
+                continue;
+            }
+
+            PonderedMove pondered = { -1, 0, depth_ };
+            iterativeDeepening_(reply, pondered.move, pondered.score);
+            if (stopped_())
+            {
+                return; //interrupted, the result is not valid.
+            }
+            ponderMoves_[BitBoard(reply).key()] = pondered;
+        }
+    }
+
     /**
      * Calls minimax (without alpha-beta pruning), gets the best move and drop the piece at the location.
      */
@@ -50,16 +197,76 @@ namespace Connect4
         std::cout << "AI (no alpha beta) drops piece on column " << bestMove << "." << std::endl;
     }
 
+    /**
+     * Search depth 1, 2, ... up to depth_, every iteration trying the best move of the previous one
+     * first. When the search is stopped (stop(), the time budget or the end of pondering), the
+     * move, score and root children of the last completed depth are kept. Returns false, with
+     * bestMove -1, if not even depth 1 was completed.
+     */
+    bool MiniMaxAiPlayer::iterativeDeepening_(const Board& board, int& bestMove, int& bestScore)
+    {
+        bestMove = -1;
+        std::vector<SearchStats::RootChild> completedChildren;
+        for (int depth = 1; depth <= depth_; depth++)
+        {
+            rootDepth_ = depth;
+            rootFirst_ = bestMove;
+            if (searchStats_)
+            {
+                searchStats_->rootChildren.clear();
+            }
+            int move = -1;
+            int score = miniMax_(board, move, depth, INT_MIN, INT_MAX, true);
+            if (stopped_())
+            {
+                break;
+            }
+            bestMove = move;
+            bestScore = score;
+            if (searchStats_)
+            {
+                searchStats_->depth = depth;
+                for (SearchStats::RootChild& child : searchStats_->rootChildren)
+                {
+                    child.bound = child.column != move; //the root starts with a full window, only the best move's score is exact.
+                }
+                completedChildren.swap(searchStats_->rootChildren);
+            }
+        }
+        if (searchStats_)
+        {
+            searchStats_->rootChildren.swap(completedChildren);
+        }
+        return bestMove >= 0;
+    }
+
     /**
     * Minimax with alpha-beta pruning. Significantly faster than plain vanilla minimax.
     */
     int MiniMaxAiPlayer::miniMax_(const Board& currentBoard, int& bestMove, int depth, int alpha, int beta, bool isMaximizingPlayer)
     {
+        if (stopped_())
+        {
+            return 0; //interrupted, the caller throws the result away.
+        }
+        if (searchStats_)
+        {
+            searchStats_->nodes++;
+            searchStats_->maxDepth = std::max(searchStats_->maxDepth, rootDepth_ - depth);
+            if (timeBudgetMs_ > 0 && searchStats_->nodes % TIME_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline_)
+            {
+                timeUp_ = true;
+            }
+        }
 
         //Check if there are any more valid moves.
         bool validMovesExist = currentBoard.validMovesExist();
         if (depth == 0 || !validMovesExist)
         {
+            if (searchStats_)
+            {
+                searchStats_->leaves++;
+            }
             auto winner = currentBoard.getWinner();
             if (winner == Board::Markers::AI_PLAYER) //Did the AI win?
             {
@@ -86,29 +293,52 @@ namespace Connect4
         {
             bestValue = INT_MIN;
             const std::vector<int>& rowInColumn = currentBoard.getMoves();
-            for (int col = 0; col < rowInColumn.size(); col++)
+            const int nCols = static_cast<int>(rowInColumn.size());
+
+            //at the root, the previous iteration's best move first, then left to right.
+            const int first = depth == rootDepth_ ? rootFirst_ : -1;
+            for (int i = first >= 0 ? -1 : 0; i < nCols; i++)
             {
-                if (rowInColumn[col] >= currentBoard.getNumRows())
+                const int col = i < 0 ? first : i;
+                if ((i >= 0 && col == first) || rowInColumn[col] >= static_cast<int>(currentBoard.getNumRows()))
                 {
                     continue;
                 }
                 //make a copy of the board and apply the move
                 //TODO: apply move and undo move instead of making a copy. This is especially important for larger games.
+                CONNECT4_ALLOC_SCOPE(AllocCategory::BOARD);
                 Board temp = currentBoard;
 
                 temp.dropPiece(col, Board::Markers::AI_PLAYER);
 
                 int tempBestMove; //it seems you can pass in bestMove. it functions very much like a global variable.
 
+                const long long nodesBefore = searchStats_ ? searchStats_->nodes : 0;
                 int score = miniMax_(temp, tempBestMove, depth - 1, alpha, beta, false);
+                if (depth == rootDepth_ && stopped_())
+                {
+                    break; //stopped: the iteration is thrown away.
+                }
+                if (searchStats_ && depth == rootDepth_)
+                {
+                    searchStats_->rootChildren.push_back({ col, searchStats_->nodes - nodesBefore, static_cast<double>(score), true });
+                }
                 if (score > bestValue)
                 {
                     bestValue = score;
                     bestMove = col;
                 }
+                if (searchStats_ && depth == rootDepth_ && progressDue_())
+                {
+                    reportProgress_(bestMove, bestValue);
+                }
                 alpha = std::max(alpha, bestValue);
                 if (beta <= alpha)
                 {
+                    if (searchStats_)
+                    {
+                        searchStats_->cutoffs++;
+                    }
                     break;
                 }
             }
@@ -125,6 +355,7 @@ namespace Connect4
                     continue;
                 }
                 //make a copy of the board and apply the move
+                CONNECT4_ALLOC_SCOPE(AllocCategory::BOARD);
                 Board temp = currentBoard;
 
                 temp.dropPiece(col, Board::Markers::HUMAN_PLAYER);
@@ -140,6 +371,10 @@ namespace Connect4
                 beta = std::min(beta, bestValue);
                 if (beta <= alpha)
                 {
+                    if (searchStats_)
+                    {
+                        searchStats_->cutoffs++;
+                    }
                     break;
                 }
             }
@@ -191,6 +426,7 @@ namespace Connect4
                     continue;
                 }
                 //make a copy of the board and apply the move
+                CONNECT4_ALLOC_SCOPE(AllocCategory::BOARD);
                 Board temp = currentBoard;
 
                 temp.dropPiece(col, Board::Markers::AI_PLAYER);
@@ -218,6 +454,7 @@ namespace Connect4
                     continue;
                 }
                 //make a copy of the board and apply the move
+                CONNECT4_ALLOC_SCOPE(AllocCategory::BOARD);
                 Board temp = currentBoard;
 
                 temp.dropPiece(col, Board::Markers::HUMAN_PLAYER);
@@ -240,11 +477,36 @@ namespace Connect4
      * Compute the relative strength of a board configuration (minimax heuristic function)
      */
     int MiniMaxAiPlayer::computeScore_(const Board& board) const
+    {
+        //as in Board::getWinner, four in a row is compiled with the window length fixed.
+        return board.getConnect() == 4 ? windowsScore_<4>(board) : windowsScore_<0>(board);
+    }
+
+    /**
+     * computeScore_() over windows of Connect cells, or board.getConnect() cells if Connect is 0.
+     */
+    template <int Connect>
+    int MiniMaxAiPlayer::windowsScore_(const Board& board) const
     {
         int score = 0;
         const auto& board_ = board.getBoard();
-        size_t nRows = board_.size();
-        size_t nCols = board_[0].size();
+        const int nRows = static_cast<int>(board_.size());
+        const int nCols = static_cast<int>(board_[0].size());
+        const int connect = Connect > 0 ? Connect : board.getConnect();
+
+        //score of the connect cells starting at (r, c), stepping by (dr, dc).
+        auto windowScore = [&](int r, int c, int dr, int dc)
+        {
+            int numAiMarkers = 0;
+            int numHumanMarkers = 0;
+            for (int k = 0; k < connect; k++)
+            {
+                auto m = board_[r + k * dr][c + k * dc];
+                numAiMarkers += (m == Board::Markers::AI_PLAYER);
+                numHumanMarkers += (m == Board::Markers::HUMAN_PLAYER);
+            }
+            return lineScore_(numAiMarkers, numHumanMarkers, connect);
+        };
 
 
         //Uncomment the block below to try a heurisitic function that gives more weight to center area (like in chess strategy)
@@ -282,38 +544,38 @@ namespace Connect4
         */
 
         // Check diagonal oriented '/'
-        for (auto r = 0; r <= nRows - CONNECT_SIZE; r++)
+        for (int r = 0; r <= nRows - connect; r++)
         {
-            for (auto c = 0; c <= nCols - CONNECT_SIZE; c++)
+            for (int c = 0; c <= nCols - connect; c++)
             {
-                score += lineScore_(board_[r][c], board_[r + 1][c + 1], board_[r + 2][c + 2], board_[r + 3][c + 3]);
+                score += windowScore(r, c, 1, 1);
             }
         }
 
         // Check diagonal oriented '\'
-        for (auto r = 0; r <= nRows - CONNECT_SIZE; r++)
+        for (int r = 0; r <= nRows - connect; r++)
         {
-            for (auto c = CONNECT_SIZE - 1; c < nCols; c++)
+            for (int c = connect - 1; c < nCols; c++)
             {
-                score += lineScore_(board_[r][c], board_[r + 1][c - 1], board_[r + 2][c - 2], board_[r + 3][c - 3]);
+                score += windowScore(r, c, 1, -1);
             }
         }
 
         // Check rows (horizontal)
-        for (auto r = 0; r < nRows; r++)
+        for (int r = 0; r < nRows; r++)
         {
-            for (auto c = 0; c <= nCols - CONNECT_SIZE; c++)
+            for (int c = 0; c <= nCols - connect; c++)
             {
-                score += lineScore_(board_[r][c], board_[r][c + 1], board_[r][c + 2], board_[r][c + 3]);
+                score += windowScore(r, c, 0, 1);
             }
         }
 
         // Check columns (vertical)
-        for (auto r = 0; r <= nRows - CONNECT_SIZE; r++)
+        for (int r = 0; r <= nRows - connect; r++)
         {
-            for (auto c = 0; c < nCols; c++)
+            for (int c = 0; c < nCols; c++)
             {
-                score += lineScore_(board_[r][c], board_[r + 1][c], board_[r + 2][c], board_[r + 3][c]);
+                score += windowScore(r, c, 1, 0);
             }
         }
 
@@ -321,33 +583,25 @@ namespace Connect4
     }
 
     /**
-     * Helper method for the minimax heuristic function.
+     * Helper method for the minimax heuristic function: the score of a window of connect cells
+     * holding the given numbers of AI and human markers.
      */
-    int MiniMaxAiPlayer::lineScore_(Board::Markers m1, Board::Markers m2, Board::Markers m3, Board::Markers m4) const
+    int MiniMaxAiPlayer::lineScore_(int numAiMarkers, int numHumanMarkers, int connect) const
     {
-        int score = 0;
-
-        //Count the number of occurrences of a marker, given a set of 4 markers. 
-        auto count = [](Board::Markers m1, Board::Markers m2, Board::Markers m3, Board::Markers m4, Board::Markers m)
-        {
-            return (m == m1) + (m == m2) + (m == m3) + (m == m4);
-        };
-        int numAiMarkers = count(m1, m2, m3, m4, Board::Markers::AI_PLAYER);
-        int numHumanMarkers = count(m1, m2, m3, m4, Board::Markers::HUMAN_PLAYER);
-        int numEmptyMarkers = CONNECT_SIZE - numAiMarkers - numHumanMarkers;
+        int numEmptyMarkers = connect - numAiMarkers - numHumanMarkers;
 
         //opponent is always human Player.
-        if (numAiMarkers == 4)
+        if (numAiMarkers == connect)
             return WINNING_SCORE; // I think we never come here.
-        else if (numHumanMarkers == 4)
+        else if (numHumanMarkers == connect)
             return -WINNING_SCORE; // I dont think we ever come here. Need an assert statement here.
-        else if (numAiMarkers == 3 && numEmptyMarkers == 1)
+        else if (numAiMarkers == connect - 1 && numEmptyMarkers == 1)
             return 5;
-        else if (numAiMarkers == 2 && numEmptyMarkers == 2)
+        else if (numAiMarkers == connect - 2 && numEmptyMarkers == 2)
             return 2;
-        else if (numHumanMarkers == 3 && numEmptyMarkers == 1)
+        else if (numHumanMarkers == connect - 1 && numEmptyMarkers == 1)
             return -4;
         else
-            return score;
+            return 0;
     }
 }
\ No newline at end of file
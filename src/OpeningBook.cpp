@@ -0,0 +1,80 @@
+#include <cstdlib>
+#include <istream>
+#include <string>
+#include "BitBoard.h"
+#include "OpeningBook.h"
+
+namespace Connect4
+{
+    long long OpeningBook::load(std::istream& in)
+    {
+        long long added = 0;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const size_t tab = line.find('\t');
+            if (tab == std::string::npos || tab + 1 >= line.size())
+            {
+                continue;
+            }
+            const int column = line[tab + 1] - '1';
+            const size_t scoreTab = line.find('\t', tab + 1);
+            if (column < 0 || column > 6 || (scoreTab != std::string::npos && scoreTab != tab + 2))
+            {
+                continue; //"none" or "error"
+            }
+            const double score = scoreTab == std::string::npos ? 0.0 : std::atof(line.c_str() + scoreTab + 1);
+
+            const std::string moves = line.substr(0, tab);
+            std::string mirrored = moves;
+            for (char& ch : mirrored)
+            {
+                ch = static_cast<char>('1' + '7' - ch);
+            }
+            if (add_(moves, column, score))
+            {
+                add_(mirrored, 6 - column, score);
+                added++;
+            }
+        }
+        return added;
+    }
+
+    /**
+     * The book move for the side to move on board (a 6x7 board). Returns false if board isn't in the book.
+     */
+    bool OpeningBook::lookup(const Board& board, int& column, double& score) const
+    {
+        if (entries_.empty() || board.getNumRows() != 6 || board.getNumCols() != 7 || board.getConnect() != CONNECT_SIZE)
+        {
+            return false;
+        }
+        auto it = entries_.find(BitBoard(board).key());
+        if (it == entries_.end())
+        {
+            return false;
+        }
+        column = it->second.column;
+        score = it->second.score;
+        return true;
+    }
+
+    size_t OpeningBook::size() const
+    {
+        return entries_.size();
+    }
+
+    /**
+     * Returns false if column is not a legal move after moves.
+     */
+    bool OpeningBook::add_(const std::string& moves, int column, double score)
+    {
+        Board board;
+        if (board.playMoves(moves) == false || board.gameEnded() || board.getMoves()[column] >= static_cast<int>(board.getNumRows()))
+        {
+            return false;
+        }
+        entries_[BitBoard(board).key()] = { column, score };
+        return true;
+    }
+}
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "Perft.h"
+
+namespace Connect4
+{
+    //moves made before the work is split between the threads.
+    static constexpr int SPLIT_DEPTH = 3;
+
+    //the hash table is only worth it for subtrees of at least this depth.
+    static constexpr int MIN_HASH_DEPTH = 3;
+
+    //depths 0-9 agree between perft() and ParallelPerft, depths 10-11 between ParallelPerft with and
+    //without the hash table.
+    const long long ParallelPerft::KNOWN_COUNTS[] = {
+        1,
+        7,
+        49,
+        343,
+        2401,
+        16807,
+        117649,
+        823536,
+        5673234,
+        39394572,
+        268031646,
+        1844590828,
+    };
+    const int ParallelPerft::NUM_KNOWN_COUNTS = sizeof(KNOWN_COUNTS) / sizeof(KNOWN_COUNTS[0]);
+
+    long long perft(const Board& board, int depth, Board::Markers toMove)
+    {
+        if (depth == 0)
+        {
+            return 1;
+        }
+        if (board.gameEnded())
+        {
+            return 0;
+        }
+
+        const Board::Markers next = toMove == Board::Markers::AI_PLAYER ? Board::Markers::HUMAN_PLAYER : Board::Markers::AI_PLAYER;
+        const std::vector<int>& rowInColumn = board.getMoves();
+        long long nodes = 0;
+        for (int col = 0; col < static_cast<int>(rowInColumn.size()); col++)
+        {
+            if (rowInColumn[col] >= static_cast<int>(board.getNumRows()))
+            {
+                continue;
+            }
+            Board child = board;
+            child.dropPiece(col, toMove);
+            nodes += perft(child, depth - 1, next);
+        }
+        return nodes;
+    }
+
+    /**
+     * numThreads 0: one thread per hardware thread. hashEntries is rounded down to a power of 2.
+     */
+    ParallelPerft::ParallelPerft(int numThreads, size_t hashEntries)
+    {
+        numThreads_ = numThreads > 0 ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        size_t size = 1;
+        while (size * 2 <= hashEntries)
+        {
+            size *= 2;
+        }
+        hashMask_ = size - 1;
+        table_.reset(new Entry[size]);
+        for (size_t i = 0; i < size; i++)
+        {
+            table_[i].check = 0;
+            table_[i].data = 0; //depth 0 is never stored, so an empty entry never matches.
+        }
+    }
+
+    long long ParallelPerft::count(const BitBoard& board, int depth, bool isAiTurn)
+    {
+        if (depth <= SPLIT_DEPTH || numThreads_ == 1)
+        {
+            return search_(board, depth, isAiTurn);
+        }
+
+        //the positions SPLIT_DEPTH moves deep are the tasks.
+        struct Task
+        {
+            BitBoard board;
+            bool isAiTurn;
+        };
+        std::vector<Task> tasks{ { board, isAiTurn } };
+        for (int d = 0; d < SPLIT_DEPTH; d++)
+        {
+            std::vector<Task> next;
+            for (const Task& task : tasks)
+            {
+                const bool mover = !task.isAiTurn;
+                if (task.board.isFull() || task.board.hasAlignment(mover ? task.board.getAiMask() : task.board.getHumanMask()))
+                {
+                    continue;
+                }
+                for (uint64_t moves = task.board.possibleMoves(); moves; moves &= moves - 1)
+                {
+                    Task child = task;
+                    child.board.play(moves & (0 - moves), task.isAiTurn);
+                    child.isAiTurn = !task.isAiTurn;
+                    next.push_back(child);
+                }
+            }
+            tasks.swap(next);
+        }
+
+        std::atomic<size_t> nextTask{ 0 };
+        std::atomic<long long> total{ 0 };
+        auto worker = [&]() {
+            long long nodes = 0;
+            for (size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+            {
+                nodes += search_(tasks[i].board, depth - SPLIT_DEPTH, tasks[i].isAiTurn);
+            }
+            total += nodes;
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads_; i++)
+        {
+            threads.emplace_back(worker);
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        return total;
+    }
+
+    long long ParallelPerft::search_(const BitBoard& board, int depth, bool isAiTurn)
+    {
+        if (depth == 0)
+        {
+            return 1;
+        }
+        //only the player who just moved can have won.
+        if (board.isFull() || board.hasAlignment(isAiTurn ? board.getHumanMask() : board.getAiMask()))
+        {
+            return 0;
+        }
+        const uint64_t moves = board.possibleMoves();
+        if (depth == 1)
+        {
+            return popCount(moves);
+        }
+
+        long long nodes = 0;
+        const uint64_t key = board.key();
+        if (depth >= MIN_HASH_DEPTH && probe_(key, depth, nodes))
+        {
+            return nodes;
+        }
+        for (uint64_t m = moves; m; m &= m - 1)
+        {
+            BitBoard child = board;
+            child.play(m & (0 - m), isAiTurn);
+            nodes += search_(child, depth - 1, !isAiTurn);
+        }
+        if (depth >= MIN_HASH_DEPTH)
+        {
+            store_(key, depth, nodes);
+        }
+        return nodes;
+    }
+
+    bool ParallelPerft::probe_(uint64_t key, int depth, long long& count) const
+    {
+        const Entry& entry = table_[(key * 0x9E3779B97F4A7C15ull >> 20) & hashMask_];
+        const uint64_t data = entry.data.load(std::memory_order_relaxed);
+        const uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || static_cast<int>(data & 63) != depth)
+        {
+            return false;
+        }
+        count = static_cast<long long>(data >> 6);
+        return true;
+    }
+
+    /**
+     * Always replace: the newest subtrees are the likeliest to transpose again soon.
+     */
+    void ParallelPerft::store_(uint64_t key, int depth, long long count)
+    {
+        Entry& entry = table_[(key * 0x9E3779B97F4A7C15ull >> 20) & hashMask_];
+        const uint64_t data = static_cast<uint64_t>(count) << 6 | static_cast<uint64_t>(depth);
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+}
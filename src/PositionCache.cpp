@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "PositionCache.h"
+
+namespace Connect4
+{
+    constexpr int PositionCache::MAX_EFFORT; //std::min takes it by reference, C++11 needs the definition.
+
+    PositionCache::PositionCache(size_t entries)
+    {
+        size_t size = 1;
+        while (size * 2 <= entries)
+        {
+            size *= 2;
+        }
+        hashMask_ = size - 1;
+        table_.reset(new Entry[size]);
+        clear();
+    }
+
+    bool PositionCache::probe(uint64_t key, int engine, int effort, int& column, double& score) const
+    {
+        const Entry& entry = table_[index_(key)];
+        const uint64_t data = entry.data.load(std::memory_order_relaxed);
+        const uint64_t check = entry.check.load(std::memory_order_relaxed);
+        //an empty entry is all zeros and stored entries keep column + 1 > 0, so an empty slot never matches a key.
+        if ((check ^ data) != key || (data & 0xff) == 0 || static_cast<int>(data >> 8 & 0xf) != engine
+            || static_cast<int>(data >> 12 & MAX_EFFORT) < std::min(effort, MAX_EFFORT))
+        {
+            return false;
+        }
+        column = static_cast<int>(data & 0xff) - 1;
+        const uint32_t bits = static_cast<uint32_t>(data >> 32);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        score = value;
+        return true;
+    }
+
+    /**
+     * Always replace: the positions of the games being played are the likeliest to come back.
+     */
+    void PositionCache::store(uint64_t key, int engine, int effort, int column, double score)
+    {
+        assert(column >= 0 && column < 255 && engine >= 0 && engine < 16 && effort >= 0);
+        const float value = static_cast<float>(score);
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint64_t data = static_cast<uint64_t>(bits) << 32 | static_cast<uint64_t>(std::min(effort, MAX_EFFORT)) << 12
+            | static_cast<uint64_t>(engine) << 8 | static_cast<uint64_t>(column + 1);
+
+        Entry& entry = table_[index_(key)];
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    /**
+     * Not safe while other threads use the cache.
+     */
+    void PositionCache::clear()
+    {
+        for (size_t i = 0; i <= hashMask_; i++)
+        {
+            table_[i].check = 0;
+            table_[i].data = 0;
+        }
+    }
+
+    size_t PositionCache::index_(uint64_t key) const
+    {
+        return (key * 0x9E3779B97F4A7C15ull >> 20) & hashMask_;
+    }
+}
@@ -0,0 +1,270 @@
+#include <cmath>
+#include <limits>
+#include "RolloutEngine.h"
+
+namespace Connect4
+{
+    RolloutEngine::RolloutEngine(uint64_t seed) : rand_{ seed }, policy_{ RolloutPolicy::UNIFORM }, simd_{ seed }, simdLanes_{ 8 } {}
+
+    void RolloutEngine::seed(uint64_t seed)
+    {
+        rand_.seed(seed);
+        simd_.seed(seed);
+    }
+
+    /**
+     * Number of playouts the vector kernel runs together (4, 8 or 16), or 0 to always play them
+     * one at a time. Defaults to 8.
+     */
+    void RolloutEngine::setSimdLanes(int lanes)
+    {
+        simdLanes_ = lanes;
+        if (lanes > 0)
+        {
+            simd_.setLanes(lanes);
+        }
+    }
+
+    void RolloutEngine::setPolicy(RolloutPolicy policy)
+    {
+        policy_ = policy;
+    }
+
+    RolloutPolicy RolloutEngine::getPolicy() const
+    {
+        return policy_;
+    }
+
+    template <typename BoardT>
+    int RolloutEngine::rollout(const BoardT& board, bool isAiTurn, BoardT* finalBoard)
+    {
+        auto winner = board.getWinner();
+        if (winner != Board::Markers::NONE)
+        {
+            if (finalBoard)
+            {
+                *finalBoard = board;
+            }
+            return winner == Board::Markers::AI_PLAYER ? 1 : -1;
+        }
+
+        BoardT brd = board; //make a copy. We are going to modify this.
+        const int maxPlies = std::numeric_limits<int>::max();
+        int reward = (policy_ == RolloutPolicy::TACTICAL) ? rolloutTactical_(brd, isAiTurn, maxPlies) : rolloutUniform_(brd, isAiTurn, maxPlies);
+        if (finalBoard)
+        {
+            *finalBoard = brd;
+        }
+        return reward;
+    }
+
+    template <typename BoardT>
+    double RolloutEngine::truncatedRollout(const BoardT& board, bool isAiTurn, int plies, BoardT* finalBoard)
+    {
+        auto winner = board.getWinner();
+        if (winner != Board::Markers::NONE)
+        {
+            if (finalBoard)
+            {
+                *finalBoard = board;
+            }
+            return winner == Board::Markers::AI_PLAYER ? 1.0 : -1.0;
+        }
+
+        BoardT brd = board;
+        int reward = (policy_ == RolloutPolicy::TACTICAL) ? rolloutTactical_(brd, isAiTurn, plies) : rolloutUniform_(brd, isAiTurn, plies);
+        if (finalBoard)
+        {
+            *finalBoard = brd;
+        }
+        if (reward != UNFINISHED)
+        {
+            return reward;
+        }
+
+        //the heuristic misses a win in one for the player to move at the cutoff.
+        const bool isAiToMove = (plies % 2 == 0) == isAiTurn;
+        if (brd.possibleMoves() & brd.winningCells(isAiToMove ? brd.getAiMask() : brd.getHumanMask()))
+        {
+            return isAiToMove ? 1.0 : -1.0;
+        }
+        return heuristicValue(brd);
+    }
+
+    template <typename BoardT>
+    double RolloutEngine::alphaBeta(const BoardT& board, bool isAiTurn, int depth)
+    {
+        auto winner = board.getWinner();
+        if (winner != Board::Markers::NONE)
+        {
+            return winner == Board::Markers::AI_PLAYER ? 1.0 : -1.0;
+        }
+
+        int score = alphaBeta_(board, isAiTurn, depth, -WIN_SCORE - depth - 1, WIN_SCORE + depth + 1);
+        score = isAiTurn ? score : -score;
+        if (score >= WIN_SCORE || score <= -WIN_SCORE)
+        {
+            return score > 0 ? 1.0 : -1.0;
+        }
+        return std::tanh(score / HEURISTIC_SCALE);
+    }
+
+    template <typename BoardT>
+    double RolloutEngine::heuristicValue(const BoardT& board)
+    {
+        return std::tanh(board.windowScore() / HEURISTIC_SCALE);
+    }
+
+    /**
+     * Negamax, the score is from the point of view of the player to move. Wins closer to the root
+     * score higher. Moves are searched center out, like MiniMaxAiPlayer does.
+     */
+    template <typename BoardT>
+    int RolloutEngine::alphaBeta_(const BoardT& brd, bool isAiTurn, int depth, int alpha, int beta)
+    {
+        using Mask = typename BoardT::Mask;
+        Mask moves = brd.possibleMoves();
+        if (!moves)
+        {
+            return 0; //board is full, tie.
+        }
+        if (moves & brd.winningCells(isAiTurn ? brd.getAiMask() : brd.getHumanMask()))
+        {
+            return WIN_SCORE + depth;
+        }
+        if (depth == 0)
+        {
+            int score = brd.windowScore();
+            return isAiTurn ? score : -score;
+        }
+
+        const int nCols = brd.getNumCols();
+        for (int i = 0; i < nCols; i++)
+        {
+            int col = (nCols - 1) / 2 + ((i % 2) ? -(i + 1) / 2 : i / 2);
+            Mask move = moves & brd.columnMask(col);
+            if (!move)
+            {
+                continue;
+            }
+            BoardT child = brd;
+            child.play(move, isAiTurn);
+            int score = -alphaBeta_(child, !isAiTurn, depth - 1, -beta, -alpha);
+            if (score > alpha)
+            {
+                alpha = score;
+                if (alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+        return alpha;
+    }
+
+    template <typename BoardT>
+    int RolloutEngine::rolloutUniform_(BoardT& brd, bool isAiTurn, int maxPlies)
+    {
+        for (int ply = 0; ply < maxPlies; ply++)
+        {
+            typename BoardT::Mask moves = brd.possibleMoves();
+            if (!moves)
+            {
+                return 0; //board is full, tie.
+            }
+            brd.play(pickMove(moves), isAiTurn);
+
+            //only the player who just moved can have completed a line.
+            if (brd.hasAlignment(isAiTurn ? brd.getAiMask() : brd.getHumanMask()))
+            {
+                return isAiTurn ? 1 : -1;
+            }
+            isAiTurn = !isAiTurn;
+        }
+        return UNFINISHED;
+    }
+
+    /**
+     * Threat-aware playout. The threat masks cost a few dozen shifts per move, and the playouts
+     * end earlier because missed wins are no longer played past.
+     */
+    template <typename BoardT>
+    int RolloutEngine::rolloutTactical_(BoardT& brd, bool isAiTurn, int maxPlies)
+    {
+        using Mask = typename BoardT::Mask;
+        for (int ply = 0; ply < maxPlies; ply++)
+        {
+            Mask moves = brd.possibleMoves();
+            if (!moves)
+            {
+                return 0; //board is full, tie.
+            }
+
+            Mask own = isAiTurn ? brd.getAiMask() : brd.getHumanMask();
+            Mask opponent = isAiTurn ? brd.getHumanMask() : brd.getAiMask();
+            Mask wins = moves & brd.winningCells(own);
+            if (wins)
+            {
+                brd.play(pickMove(wins), isAiTurn);
+                return isAiTurn ? 1 : -1;
+            }
+
+            Mask blocks = moves & brd.winningCells(opponent);
+            brd.play(pickMove(blocks ? blocks : moves), isAiTurn);
+            isAiTurn = !isAiTurn;
+        }
+        return UNFINISHED;
+    }
+
+    int RolloutEngine::rollouts(const BitBoard& board, bool isAiTurn, int count)
+    {
+        int reward = 0;
+        if (policy_ == RolloutPolicy::UNIFORM && simdLanes_ > 0 && count >= simdLanes_ && SimdRollout::supports(board))
+        {
+            int batched = count - count % simdLanes_;
+            reward += simd_.rollouts(board, isAiTurn, batched);
+            count -= batched;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            reward += rollout(board, isAiTurn);
+        }
+        return reward;
+    }
+
+    /**
+     * Playouts on boards wider than 64 bits, one at a time.
+     */
+    int RolloutEngine::rollouts(const WideBitBoard& board, bool isAiTurn, int count)
+    {
+        int reward = 0;
+        for (int i = 0; i < count; i++)
+        {
+            reward += rollout(board, isAiTurn);
+        }
+        return reward;
+    }
+
+    template <typename Mask>
+    Mask RolloutEngine::pickMove(Mask moves)
+    {
+        //drop the k lowest moves, k is at most nCols - 1.
+        uint32_t k = rand_.bounded(popCount(moves));
+        for (uint32_t i = 0; i < k; i++)
+        {
+            moves &= moves - Mask(1);
+        }
+        return moves & (~moves + Mask(1));
+    }
+
+    template int RolloutEngine::rollout(const BitBoard&, bool, BitBoard*);
+    template int RolloutEngine::rollout(const WideBitBoard&, bool, WideBitBoard*);
+    template double RolloutEngine::truncatedRollout(const BitBoard&, bool, int, BitBoard*);
+    template double RolloutEngine::truncatedRollout(const WideBitBoard&, bool, int, WideBitBoard*);
+    template double RolloutEngine::alphaBeta(const BitBoard&, bool, int);
+    template double RolloutEngine::alphaBeta(const WideBitBoard&, bool, int);
+    template double RolloutEngine::heuristicValue(const BitBoard&);
+    template double RolloutEngine::heuristicValue(const WideBitBoard&);
+    template uint64_t RolloutEngine::pickMove(uint64_t);
+    template Mask128 RolloutEngine::pickMove(Mask128);
+}
@@ -0,0 +1,55 @@
+#include <ostream>
+#include "SearchStats.h"
+
+namespace Connect4
+{
+    void SearchStats::reset()
+    {
+        move = -1;
+        score = 0.0;
+        nodes = 0;
+        leaves = 0;
+        cutoffs = 0;
+        iterations = 0;
+        rollouts = 0;
+        maxDepth = 0;
+        depth = 0;
+        elapsedMs = 0.0;
+        nodesPerSecond = 0.0;
+        rootChildren.clear();
+        allocs = AllocCounts();
+    }
+
+    /**
+     * One JSON object on one line (JSON lines), newline included. The allocation counts are only
+     * written when they are counted.
+     */
+    void SearchStats::writeJson(std::ostream& out) const
+    {
+        out << "{\"engine\":\"" << engine << "\",\"move\":" << move << ",\"score\":" << score
+            << ",\"nodes\":" << nodes << ",\"leaves\":" << leaves << ",\"cutoffs\":" << cutoffs
+            << ",\"iterations\":" << iterations << ",\"rollouts\":" << rollouts << ",\"maxDepth\":" << maxDepth << ",\"depth\":" << depth
+            << ",\"elapsedMs\":" << elapsedMs << ",\"nodesPerSecond\":" << nodesPerSecond << ",\"rootChildren\":[";
+        for (size_t i = 0; i < rootChildren.size(); i++)
+        {
+            out << (i ? "," : "") << "{\"column\":" << rootChildren[i].column << ",\"visits\":" << rootChildren[i].visits;
+            if (rootChildren[i].bound == false)
+            {
+                out << ",\"score\":" << rootChildren[i].score;
+            }
+            out << "}";
+        }
+        out << "]";
+        if (AllocStats::enabled())
+        {
+            out << ",\"allocations\":" << allocs.totalAllocations() << ",\"allocatedBytes\":" << allocs.totalBytes() << ",\"allocationsByCategory\":{";
+            for (int i = 0; i < AllocCounts::NUM_CATEGORIES; i++)
+            {
+                out << (i ? "," : "") << "\"" << AllocCounts::categoryName(i) << "\":{\"allocations\":" << allocs.allocations[i]
+                    << ",\"bytes\":" << allocs.bytes[i] << "}";
+            }
+            out << "}";
+        }
+        out << "}\n";
+    }
+}
@@ -0,0 +1,314 @@
+#include "SimdRollout.h"
+#include <cassert>
+#ifdef CONNECT4_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+//MSVC compiles AVX2 intrinsics without /arch:AVX2.
+#define CONNECT4_TARGET_AVX2
+#else
+//only the AVX2 kernel gets AVX2 code, the rest of the engine still runs on any x86-64.
+#define CONNECT4_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Connect4
+{
+    SimdRollout::SimdRollout(uint64_t seed, int lanes)
+    {
+        setLanes(lanes);
+        this->seed(seed);
+    }
+
+    /**
+     * Seed every lane through splitmix64, so that the lanes are uncorrelated and no state is 0.
+     */
+    void SimdRollout::seed(uint64_t seed)
+    {
+        uint64_t z = seed;
+        auto splitMix = [&z]()
+        {
+            z += 0x9E3779B97F4A7C15ull;
+            uint64_t x = z;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        };
+        for (int i = 0; i < MAX_LANES; i++)
+        {
+            state0_[i] = splitMix() | 1;
+            state1_[i] = splitMix();
+        }
+    }
+
+    void SimdRollout::setLanes(int lanes)
+    {
+        assert(lanes == 4 || lanes == 8 || lanes == 16);
+        lanes_ = lanes;
+    }
+
+    int SimdRollout::getLanes() const
+    {
+        return lanes_;
+    }
+
+#ifdef CONNECT4_AVX2
+    /**
+     * True if the CPU, and the OS for the 256 bit registers, support AVX2.
+     */
+    static bool cpuHasAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsaveAndAvx) != osxsaveAndAvx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+#endif
+
+    bool SimdRollout::isVectorized()
+    {
+#ifdef CONNECT4_AVX2
+        static const bool avx2 = cpuHasAvx2();
+        return avx2;
+#else
+        return false;
+#endif
+    }
+
+    int SimdRollout::rollouts(const BitBoard& board, bool isAiTurn, int count)
+    {
+        auto winner = board.getWinner();
+        if (winner != Board::Markers::NONE)
+        {
+            return (winner == Board::Markers::AI_PLAYER) ? count : -count;
+        }
+        if (board.isFull())
+        {
+            return 0;
+        }
+
+        int reward = 0;
+        for (int done = 0; done < count; done += lanes_)
+        {
+            switch (lanes_)
+            {
+            case 4:
+                reward += rolloutGroup_<4>(board, isAiTurn);
+                break;
+            case 8:
+                reward += rolloutGroup_<8>(board, isAiTurn);
+                break;
+            default:
+                reward += rolloutGroup_<16>(board, isAiTurn);
+                break;
+            }
+        }
+        return reward;
+    }
+
+    template <int Lanes>
+    int SimdRollout::rolloutGroup_(const BitBoard& board, bool isAiTurn)
+    {
+#ifdef CONNECT4_AVX2
+        if (isVectorized())
+        {
+            return rolloutGroupAvx2_<Lanes>(board, isAiTurn);
+        }
+#endif
+        return rolloutGroupScalar_<Lanes>(board, isAiTurn);
+    }
+
+#ifdef CONNECT4_AVX2
+
+    CONNECT4_TARGET_AVX2 static inline __m256i rotateLeft(__m256i x, int k)
+    {
+        return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+    }
+
+    /**
+     * xoroshiro128+ on 4 lanes. https://prng.di.unimi.it/
+     */
+    CONNECT4_TARGET_AVX2 static inline __m256i nextRandom(__m256i& s0, __m256i& s1)
+    {
+        __m256i result = _mm256_add_epi64(s0, s1);
+        s1 = _mm256_xor_si256(s1, s0);
+        s0 = _mm256_xor_si256(_mm256_xor_si256(rotateLeft(s0, 24), s1), _mm256_slli_epi64(s1, 16));
+        s1 = rotateLeft(s1, 37);
+        return result;
+    }
+
+    /**
+     * Lanes with CONNECT_SIZE (four) in a row, see BitBoard::hasAlignment.
+     */
+    CONNECT4_TARGET_AVX2 static inline __m256i alignment(__m256i mask, const __m128i shifts[4], const __m128i doubleShifts[4])
+    {
+        __m256i found = _mm256_setzero_si256();
+        for (int i = 0; i < 4; i++)
+        {
+            __m256i m = _mm256_and_si256(mask, _mm256_srl_epi64(mask, shifts[i]));
+            found = _mm256_or_si256(found, _mm256_and_si256(m, _mm256_srl_epi64(m, doubleShifts[i])));
+        }
+        return found;
+    }
+
+    template <int Lanes>
+    CONNECT4_TARGET_AVX2 int SimdRollout::rolloutGroupAvx2_(const BitBoard& board, bool isAiTurn)
+    {
+        constexpr int R = Lanes / 4; //registers
+        const int nRows = board.getNumRows();
+        const int h = nRows + 1;
+        const int numCells = nRows * board.getNumCols();
+
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i bottom = _mm256_set1_epi64x(static_cast<long long>(board.getBottomMask()));
+        const __m256i boardMask = _mm256_set1_epi64x(static_cast<long long>(board.getBoardMask()));
+        const __m256i column0 = _mm256_set1_epi64x((1ll << nRows) - 1);
+        const __m256i numCols = _mm256_set1_epi64x(board.getNumCols());
+        const __m256i height = _mm256_set1_epi64x(h);
+        const __m128i shifts[4] = { _mm_cvtsi32_si128(1), _mm_cvtsi32_si128(h), _mm_cvtsi32_si128(h - 1), _mm_cvtsi32_si128(h + 1) };
+        const __m128i doubleShifts[4] = { _mm_cvtsi32_si128(2), _mm_cvtsi32_si128(2 * h), _mm_cvtsi32_si128(2 * (h - 1)), _mm_cvtsi32_si128(2 * (h + 1)) };
+
+        __m256i ai[R], human[R], active[R], s0[R], s1[R];
+        for (int r = 0; r < R; r++)
+        {
+            ai[r] = _mm256_set1_epi64x(static_cast<long long>(board.getAiMask()));
+            human[r] = _mm256_set1_epi64x(static_cast<long long>(board.getHumanMask()));
+            active[r] = _mm256_set1_epi64x(-1);
+            //unaligned: the state is not over-aligned, new ignores alignas(32) before C++17.
+            s0[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state0_ + 4 * r));
+            s1[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state1_ + 4 * r));
+        }
+
+        int reward = 0;
+        for (int numMoves = board.getNumMoves(); ; )
+        {
+            int wins = 0;
+            bool anyActive = false;
+            for (int r = 0; r < R; r++)
+            {
+                __m256i possible = _mm256_and_si256(_mm256_add_epi64(_mm256_or_si256(ai[r], human[r]), bottom), boardMask);
+
+                //draw a column per lane, and draw again in the lanes where it is full.
+                __m256i moveBit = zero;
+                __m256i pending = active[r];
+                while (_mm256_testz_si256(pending, pending) == 0)
+                {
+                    __m256i rnd = nextRandom(s0[r], s1[r]);
+                    __m256i col = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(rnd, 32), numCols), 32);
+                    __m256i candidate = _mm256_and_si256(possible, _mm256_sllv_epi64(column0, _mm256_mul_epu32(col, height)));
+                    __m256i found = _mm256_andnot_si256(_mm256_cmpeq_epi64(candidate, zero), pending);
+                    moveBit = _mm256_or_si256(moveBit, _mm256_and_si256(candidate, found));
+                    pending = _mm256_andnot_si256(found, pending);
+                }
+
+                __m256i& player = isAiTurn ? ai[r] : human[r];
+                player = _mm256_or_si256(player, moveBit);
+
+                __m256i won = _mm256_andnot_si256(_mm256_cmpeq_epi64(alignment(player, shifts, doubleShifts), zero), active[r]);
+                wins += popCount(static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(won))));
+                active[r] = _mm256_andnot_si256(won, active[r]);
+                anyActive = anyActive || (_mm256_testz_si256(active[r], active[r]) == 0);
+            }
+            reward += isAiTurn ? wins : -wins;
+            numMoves++;
+
+            //every lane has made the same number of moves, so the remaining games are ties together.
+            if (anyActive == false || numMoves == numCells)
+            {
+                break;
+            }
+            isAiTurn = !isAiTurn;
+        }
+
+        for (int r = 0; r < R; r++)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(state0_ + 4 * r), s0[r]);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(state1_ + 4 * r), s1[r]);
+        }
+        return reward;
+    }
+
+#endif
+
+    static inline uint64_t rotateLeft(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    template <int Lanes>
+    int SimdRollout::rolloutGroupScalar_(const BitBoard& board, bool isAiTurn)
+    {
+        const int nCols = board.getNumCols();
+        const int numCells = board.getNumRows() * nCols;
+
+        uint64_t ai[Lanes], human[Lanes];
+        bool active[Lanes];
+        for (int i = 0; i < Lanes; i++)
+        {
+            ai[i] = board.getAiMask();
+            human[i] = board.getHumanMask();
+            active[i] = true;
+        }
+
+        int reward = 0;
+        for (int numMoves = board.getNumMoves(); ; )
+        {
+            int wins = 0;
+            bool anyActive = false;
+            for (int i = 0; i < Lanes; i++)
+            {
+                if (active[i] == false)
+                {
+                    continue;
+                }
+                uint64_t possible = ((ai[i] | human[i]) + board.getBottomMask()) & board.getBoardMask();
+                uint64_t moveBit = 0;
+                while (moveBit == 0)
+                {
+                    //xoroshiro128+
+                    uint64_t rnd = state0_[i] + state1_[i];
+                    state1_[i] ^= state0_[i];
+                    state0_[i] = rotateLeft(state0_[i], 24) ^ state1_[i] ^ (state1_[i] << 16);
+                    state1_[i] = rotateLeft(state1_[i], 37);
+
+                    int col = static_cast<int>(((rnd >> 32) * static_cast<uint64_t>(nCols)) >> 32);
+                    moveBit = possible & board.columnMask(col);
+                }
+
+                uint64_t& player = isAiTurn ? ai[i] : human[i];
+                player |= moveBit;
+                if (board.hasAlignment(player))
+                {
+                    wins++;
+                    active[i] = false;
+                }
+                anyActive = anyActive || active[i];
+            }
+            reward += isAiTurn ? wins : -wins;
+            numMoves++;
+
+            //every lane has made the same number of moves, so the remaining games are ties together.
+            if (anyActive == false || numMoves == numCells)
+            {
+                break;
+            }
+            isAiTurn = !isAiTurn;
+        }
+        return reward;
+    }
+}
@@ -0,0 +1,108 @@
+#include <cassert>
+#include <cmath>
+#include "Sprt.h"
+
+namespace Connect4
+{
+    //two sided 95% interval.
+    static constexpr double Z_95 = 1.959964;
+
+    //games of each result added to the counts in llr().
+    static constexpr double PSEUDO_COUNT = 0.5;
+
+    static double scoreFromElo(double elo)
+    {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+
+    static double eloFromScore(double score)
+    {
+        //the Elo difference is infinite for a score of 0 or 1.
+        const double epsilon = 1e-6;
+        score = std::fmin(std::fmax(score, epsilon), 1.0 - epsilon);
+        return -400.0 * std::log10(1.0 / score - 1.0);
+    }
+
+    /**
+     * Mean and variance of the score of one game (win 1, draw 1/2, loss 0).
+     */
+    static void scoreStats(double wins, double losses, double draws, double& mean, double& variance)
+    {
+        const double n = wins + losses + draws;
+        const double w = wins / n;
+        const double d = draws / n;
+        mean = w + d / 2.0;
+        variance = w + d / 4.0 - mean * mean;
+    }
+
+    Sprt::Sprt(double elo0, double elo1, double alpha, double beta) : score0_{ scoreFromElo(elo0) }, score1_{ scoreFromElo(elo1) },
+        lowerBound_{ std::log(beta / (1.0 - alpha)) }, upperBound_{ std::log((1.0 - beta) / alpha) }
+    {
+        assert(elo0 < elo1);
+        assert(alpha > 0.0 && alpha < 1.0 && beta > 0.0 && beta < 1.0);
+    }
+
+    /**
+     * Log likelihood ratio of H1 against H0 for the results so far. Half a win, half a loss and half
+     * a draw are added to the counts, so that the variance isn't 0 when every game so far has the
+     * same result: a one sided match is decided the fastest, not never.
+     */
+    double Sprt::llr(int wins, int losses, int draws) const
+    {
+        if (wins + losses + draws == 0)
+        {
+            return 0.0;
+        }
+        const double n = wins + losses + draws + 3.0 * PSEUDO_COUNT;
+        double mean = 0.0;
+        double variance = 0.0;
+        scoreStats(wins + PSEUDO_COUNT, losses + PSEUDO_COUNT, draws + PSEUDO_COUNT, mean, variance);
+        const double varianceOfMean = variance / n;
+        return (score1_ - score0_) * (2.0 * mean - score0_ - score1_) / (2.0 * varianceOfMean);
+    }
+
+    Sprt::Status Sprt::status(int wins, int losses, int draws) const
+    {
+        const double ratio = llr(wins, losses, draws);
+        if (ratio >= upperBound_)
+        {
+            return Status::ACCEPT_H1;
+        }
+        if (ratio <= lowerBound_)
+        {
+            return Status::ACCEPT_H0;
+        }
+        return Status::CONTINUE;
+    }
+
+    double Sprt::getLowerBound() const
+    {
+        return lowerBound_;
+    }
+
+    double Sprt::getUpperBound() const
+    {
+        return upperBound_;
+    }
+
+    /**
+     * Elo difference for the results, with the interval taken on the score and converted to Elo.
+     */
+    EloEstimate Sprt::eloEstimate(int wins, int losses, int draws)
+    {
+        EloEstimate estimate;
+        const int n = wins + losses + draws;
+        if (n == 0)
+        {
+            return estimate;
+        }
+        double mean = 0.0;
+        double variance = 0.0;
+        scoreStats(wins, losses, draws, mean, variance);
+        const double margin = Z_95 * std::sqrt(variance / n);
+        estimate.elo = eloFromScore(mean);
+        estimate.low = eloFromScore(mean - margin);
+        estimate.high = eloFromScore(mean + margin);
+        return estimate;
+    }
+}
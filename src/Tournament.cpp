@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "Tournament.h"
+
+namespace Connect4
+{
+    Tournament::Tournament(PlayerFactory aiFactory, PlayerFactory shadowFactory) : aiFactory_{ aiFactory }, shadowFactory_{ shadowFactory },
+        numGames_{ 10000 }, numThreads_{ 0 }, seed_{ 0 }, reportIntervalMs_{ 1000 }, useSprt_{ false }, recordWriter_{ nullptr }, aiEngineId_{ 0 }, shadowEngineId_{ 0 }, nRows_{ 6 }, nCols_{ 7 }, connect_{ CONNECT_SIZE }, nextGame_{ 0 }, aiWins_{ 0 }, shadowWins_{ 0 }, ties_{ 0 }, stop_{ false } {}
+
+    void Tournament::setNumGames(int numGames)
+    {
+        numGames_ = numGames;
+    }
+
+    void Tournament::setNumThreads(int numThreads)
+    {
+        numThreads_ = numThreads;
+    }
+
+    /**
+     * Worker i seeds its players with seed + i.
+     */
+    void Tournament::setSeed(int seed)
+    {
+        seed_ = seed;
+    }
+
+    void Tournament::setReportInterval(int milliseconds)
+    {
+        reportIntervalMs_ = milliseconds;
+    }
+
+    /**
+     * Stop the match early once sprt accepts or rejects "the AI player is stronger".
+     */
+    void Tournament::setSprt(const Sprt& sprt)
+    {
+        useSprt_ = true;
+        sprt_ = sprt;
+    }
+
+    /**
+     * Write every game to writer (nullptr: don't record). The ids tell the engines apart in the records.
+     */
+    void Tournament::setRecordWriter(GameRecordWriter* writer, uint16_t aiEngineId, uint16_t shadowEngineId)
+    {
+        recordWriter_ = writer;
+        aiEngineId_ = aiEngineId;
+        shadowEngineId_ = shadowEngineId;
+    }
+
+    /**
+     * Play on an nRows x nCols board, connect in a row to win. The factories must make players for that board.
+     */
+    void Tournament::setBoardSize(int nRows, int nCols, int connect)
+    {
+        assert(nRows >= connect || nCols >= connect);
+        nRows_ = nRows;
+        nCols_ = nCols;
+        connect_ = connect;
+    }
+
+    /**
+     * Play all the games and return the totals. Blocks until the last game is over.
+     */
+    TournamentResult Tournament::run(std::ostream& out)
+    {
+        nextGame_ = 0;
+        aiWins_ = 0;
+        shadowWins_ = 0;
+        ties_ = 0;
+        stop_ = false;
+
+        int numThreads = numThreads_;
+        if (numThreads <= 0)
+        {
+            numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+        numThreads = std::min(numThreads, std::max(1, numGames_));
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int i = 0; i < numThreads; i++)
+        {
+            workers.emplace_back(&Tournament::worker_, this, i);
+        }
+
+        auto seconds = [&start]() {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        //the results are only read here, the workers never wait on the reporter.
+        if (reportIntervalMs_ > 0)
+        {
+            const auto interval = std::chrono::milliseconds(reportIntervalMs_);
+            auto nextReport = start + interval;
+            while (snapshot_().games() < numGames_ && stop_ == false)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                if (std::chrono::steady_clock::now() >= nextReport)
+                {
+                    report_(out, snapshot_(), seconds());
+                    nextReport += interval;
+                }
+            }
+        }
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        if (recordWriter_)
+        {
+            recordWriter_->flush();
+        }
+
+        TournamentResult result = snapshot_();
+        if (useSprt_)
+        {
+            result.sprtStatus = sprt_.status(result.aiWins, result.shadowWins, result.ties);
+        }
+        report_(out, result, seconds());
+        if (result.sprtStatus == Sprt::Status::ACCEPT_H1)
+        {
+            out << "SPRT: H1 accepted (the AI player is stronger)\n";
+        }
+        else if (result.sprtStatus == Sprt::Status::ACCEPT_H0)
+        {
+            out << "SPRT: H0 accepted (the AI player is not stronger)\n";
+        }
+        out.flush();
+        return result;
+    }
+
+    void Tournament::worker_(int workerIndex)
+    {
+        const int seed = seed_ + workerIndex;
+        std::unique_ptr<Player> aiPlayer = aiFactory_(seed);
+        std::unique_ptr<Player> shadowPlayer = shadowFactory_(seed);
+        Board board(nRows_, nCols_, connect_);
+        GameRecord record;
+        record.header.aiEngineId = aiEngineId_;
+        record.header.shadowEngineId = shadowEngineId_;
+        record.header.aiSeed = static_cast<uint32_t>(seed);
+        record.header.shadowSeed = static_cast<uint32_t>(seed);
+        record.header.numRows = static_cast<uint8_t>(nRows_);
+        record.header.numCols = static_cast<uint8_t>(nCols_);
+        record.header.connect = static_cast<uint8_t>(connect_);
+
+        for (int game = nextGame_++; game < numGames_ && stop_ == false; game = nextGame_++)
+        {
+            board.reset();
+            const bool shadowFirst = (game % 2) == 0;
+            auto winner = playGame_(board, *aiPlayer, *shadowPlayer, shadowFirst, recordWriter_ ? &record : nullptr);
+            if (recordWriter_)
+            {
+                record.header.numMoves = static_cast<uint16_t>(record.moves.size());
+                record.header.result = winner == Board::Markers::AI_PLAYER ? 1 : (winner == Board::Markers::HUMAN_PLAYER ? -1 : 0);
+                record.header.flags = shadowFirst ? GameRecordHeader::SHADOW_FIRST : 0;
+                recordWriter_->write(record);
+            }
+            if (winner == Board::Markers::AI_PLAYER)
+            {
+                aiWins_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (winner == Board::Markers::HUMAN_PLAYER)
+            {
+                shadowWins_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                ties_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (useSprt_)
+            {
+                TournamentResult result = snapshot_();
+                if (sprt_.status(result.aiWins, result.shadowWins, result.ties) != Sprt::Status::CONTINUE)
+                {
+                    stop_ = true;
+                }
+            }
+        }
+    }
+
+    /**
+     * Play one game from the empty board and return the winner (NONE for a tie).
+     * If record is given, it receives the columns played and the time taken for every move.
+     */
+    Board::Markers Tournament::playGame_(Board& board, Player& aiPlayer, Player& shadowPlayer, bool shadowFirst, GameRecord* record)
+    {
+        if (record)
+        {
+            record->moves.clear();
+            record->moveTimesUs.clear();
+        }
+        std::vector<int> heights;
+        bool shadowTurn = shadowFirst;
+        while (board.gameEnded() == false)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (record)
+            {
+                heights = board.getMoves();
+            }
+
+            if (shadowTurn)
+            {
+                //the shadow player sees itself as AI_PLAYER.
+                board.flipMarkers();
+                shadowPlayer.play(board);
+                board.flipMarkers();
+            }
+            else
+            {
+                aiPlayer.play(board);
+            }
+
+            if (record)
+            {
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                const auto& newHeights = board.getMoves();
+                const size_t col = std::mismatch(heights.begin(), heights.end(), newHeights.begin()).first - heights.begin();
+                record->moves.push_back(static_cast<uint8_t>(col));
+                record->moveTimesUs.push_back(static_cast<uint32_t>(elapsed.count()));
+            }
+            shadowTurn = !shadowTurn;
+        }
+        return board.getWinner();
+    }
+
+    TournamentResult Tournament::snapshot_() const
+    {
+        TournamentResult result;
+        result.aiWins = aiWins_.load(std::memory_order_relaxed);
+        result.shadowWins = shadowWins_.load(std::memory_order_relaxed);
+        result.ties = ties_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    /**
+     * One progress line: results, Elo of the AI player relative to the shadow player (95% interval)
+     * and the SPRT log likelihood ratio with its bounds.
+     */
+    void Tournament::report_(std::ostream& out, const TournamentResult& result, double seconds) const
+    {
+        const int games = std::max(1, result.games());
+        const EloEstimate elo = Sprt::eloEstimate(result.aiWins, result.shadowWins, result.ties);
+        out << "Games: " << result.games()
+            << "  AI wins: " << 100.0 * result.aiWins / games << " %"
+            << "  Shadow AI wins: " << 100.0 * result.shadowWins / games << " %"
+            << "  Ties: " << 100.0 * result.ties / games << " %"
+            << "  Elo: " << elo.elo << " [" << elo.low << ", " << elo.high << "]";
+        if (useSprt_)
+        {
+            out << "  LLR: " << sprt_.llr(result.aiWins, result.shadowWins, result.ties)
+                << " [" << sprt_.getLowerBound() << ", " << sprt_.getUpperBound() << "]";
+        }
+        out << "  (" << result.games() / std::max(seconds, 1e-9) << " games/s)\n";
+    }
+}
@@ -0,0 +1,41 @@
+#include <iostream>
+#include "Board.h"
+#include "BitBoard.h"
+#include "Perft.h"
+
+namespace
+{
+    int failures = 0;
+
+    void check(long long nodes, int depth, const char* what)
+    {
+        if (nodes != Connect4::ParallelPerft::KNOWN_COUNTS[depth])
+        {
+            std::cerr << "FAILED: " << what << " depth " << depth << ": " << nodes
+                << ", expected " << Connect4::ParallelPerft::KNOWN_COUNTS[depth] << "\n";
+            failures++;
+        }
+    }
+}
+
+/**
+ * Perft of the empty board against the known counts, for Board and for bitboards on one and on
+ * several threads. Returns 1 if any check fails.
+ */
+int main()
+{
+    using namespace Connect4;
+    const int MAX_DEPTH = 8; //a couple of seconds, the deeper counts are for Connect4Cli perft.
+
+    const Board board;
+    ParallelPerft oneThread(1, 1 << 16);
+    ParallelPerft threads(4);
+    for (int d = 0; d <= MAX_DEPTH && d < ParallelPerft::NUM_KNOWN_COUNTS; d++)
+    {
+        check(perft(board, d), d, "perft(Board)");
+        check(oneThread.count(BitBoard(board), d, true), d, "ParallelPerft, 1 thread");
+        check(threads.count(BitBoard(board), d, true), d, "ParallelPerft, 4 threads");
+    }
+
+    return failures == 0 ? 0 : 1;
+}
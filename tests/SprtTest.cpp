@@ -0,0 +1,46 @@
+#include <iostream>
+#include "Sprt.h"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (condition == false)
+        {
+            std::cerr << "FAILED: " << what << "\n";
+            failures++;
+        }
+    }
+}
+
+/**
+ * Sprt decisions on one sided and balanced matches. Returns 1 if any check fails.
+ */
+int main()
+{
+    using Connect4::Sprt;
+    const Sprt sprt(0.0, 5.0, 0.05, 0.05);
+
+    //every game won: H1 is accepted, and well before a balanced match would be decided.
+    int wins = 0;
+    while (wins < 1000 && sprt.status(wins, 0, 0) == Sprt::Status::CONTINUE)
+    {
+        wins++;
+    }
+    check(sprt.status(wins, 0, 0) == Sprt::Status::ACCEPT_H1, "all wins accept H1");
+    check(wins < 100, "all wins decide within 100 games");
+
+    //every game lost: H0 is accepted.
+    check(sprt.status(0, 100, 0) == Sprt::Status::ACCEPT_H0, "all losses accept H0");
+
+    //all draws is a score of exactly elo 0, closer to H0.
+    check(sprt.llr(0, 0, 1000) < 0.0, "all draws favor H0");
+
+    //no games, no evidence.
+    check(sprt.llr(0, 0, 0) == 0.0, "no games, llr 0");
+    check(sprt.status(10, 10, 10) == Sprt::Status::CONTINUE, "even match of 30 games continues");
+
+    return failures == 0 ? 0 : 1;
+}
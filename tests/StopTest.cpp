@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Board.h"
+#include "EngineServer.h"
+#include "MctsAiPlayer.h"
+#include "MiniMaxAiPlayer.h"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (condition == false)
+        {
+            std::cerr << "FAILED: " << what << "\n";
+            failures++;
+        }
+    }
+
+    /**
+     * Run f, giving up on the whole test if it takes longer than seconds: a lost stop() searches for hours.
+     */
+    template <typename F>
+    void withinSeconds(int seconds, const char* what, F f)
+    {
+        auto done = std::async(std::launch::async, f);
+        if (done.wait_for(std::chrono::seconds(seconds)) != std::future_status::ready)
+        {
+            std::cerr << "FAILED: " << what << " (still searching after " << seconds << " s)\n";
+            std::_Exit(1);
+        }
+        done.get();
+    }
+
+    /**
+     * A stop() before play() starts is kept: play() returns at once, with a legal move.
+     */
+    void stopBeforePlay(Connect4::Player& player, const char* what)
+    {
+        withinSeconds(10, what, [&player, what]() {
+            Connect4::Board board;
+            player.clearStop();
+            player.stop();
+            player.play(board);
+            int pieces = 0;
+            for (int height : board.getMoves())
+            {
+                pieces += height;
+            }
+            check(pieces == 1, what);
+        });
+    }
+
+    int count(const std::string& text, const std::string& word)
+    {
+        int n = 0;
+        for (size_t at = text.find(word); at != std::string::npos; at = text.find(word, at + 1))
+        {
+            n++;
+        }
+        return n;
+    }
+}
+
+/**
+ * Stop requests that come before the search thread reaches play() still end the search.
+ * Returns 1 if any check fails.
+ */
+int main()
+{
+    Connect4::MiniMaxAiPlayer miniMax(42);
+    stopBeforePlay(miniMax, "minimax stopped before play");
+    Connect4::MctsAiPlayer mcts(100000000, 1);
+    stopBeforePlay(mcts, "MCTS stopped before play");
+
+    //stop right after go, and a movetime shorter than the search thread takes to start. position
+    //waits for the search to end, so a lost stop hangs here.
+    std::ostringstream out;
+    withinSeconds(30, "engine server stop after go", [&out]() {
+        std::istringstream in(
+            "engine minimax\ngo depth 42\nstop\nposition startpos\n"
+            "go depth 42 movetime 1\nposition startpos\n"
+            "engine mcts\ngo iterations 100000000\nstop\nposition startpos\n");
+        Connect4::EngineServer server;
+        server.run(in, out);
+    });
+    check(count(out.str(), "bestmove ") == 3, "engine server answers every go");
+    check(count(out.str(), "error") == 0, "engine server takes every command");
+
+    return failures == 0 ? 0 : 1;
+}